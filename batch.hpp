@@ -0,0 +1,375 @@
+#pragma once
+
+// batch.hpp - Batch mode for the native CLI: solve a stream of puzzles on a thread pool
+//
+// Input is either JSON Lines ({"grid": "...", "k": 6, "id": ...} per line, grid as a
+// newline-separated string or an array of rows) or plain ASCII grids separated by
+// blank lines. The format is detected from the first non-blank character.
+// Each puzzle produces one JSON line on the output stream. run_corpus() takes
+// the boards from a memory-mapped binary corpus (corpus.hpp) instead.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "corpus.hpp"
+#include "json.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+
+namespace enclose {
+namespace batch {
+
+using std::string;
+using std::vector;
+
+/* ---------------- Puzzle input ---------------- */
+
+struct Puzzle {
+    std::size_t index = 0;
+    json::Value id;          // echoed back when present in the input
+    int k = 6;
+    vector<string> grid;
+    PackedGridView packed;   // used instead of grid when packed.R > 0 (corpus input)
+    string error;            // set when the input record could not be parsed
+};
+
+// Split a newline separated grid into rows, dropping '\r' and empty lines
+inline vector<string> split_grid(const string& text) {
+    vector<string> grid;
+    std::istringstream iss(text);
+    string line;
+    while (std::getline(iss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) grid.push_back(line);
+    }
+    return grid;
+}
+
+// Fill id, k and grid of a puzzle from a JSON request object; throws on bad input
+inline void read_record(const json::Value& v, Puzzle& p) {
+    if (!v.is_object()) throw std::runtime_error("request must be a JSON object");
+    if (const json::Value* id = v.find("id")) p.id = *id;
+    if (const json::Value* k = v.find("k")) {
+        if (!json::get_int(*k, 0, std::numeric_limits<int>::max(), p.k)) {
+            throw std::runtime_error("\"k\" must be a whole number from 0 to INT_MAX");
+        }
+    }
+    const json::Value* g = v.find("grid");
+    if (!g) throw std::runtime_error("missing \"grid\"");
+    if (g->is_string()) {
+        p.grid = split_grid(g->str);
+    } else if (g->is_array()) {
+        for (const auto& row : g->arr) {
+            if (!row.is_string()) throw std::runtime_error("grid rows must be strings");
+            if (!row.str.empty()) p.grid.push_back(row.str);
+        }
+    } else {
+        throw std::runtime_error("\"grid\" must be a string or an array of strings");
+    }
+    if (p.grid.empty()) throw std::runtime_error("Empty grid");
+}
+
+class PuzzleReader {
+public:
+    PuzzleReader(std::istream& in, int default_k) : in_(in), default_k_(default_k) {}
+
+    bool next(Puzzle& p) {
+        if (!detected_) detect();
+        p = Puzzle();
+        p.index = count_;
+        p.k = default_k_;
+        bool ok = jsonl_ ? next_jsonl(p) : next_ascii(p);
+        if (ok) count_++;
+        return ok;
+    }
+
+private:
+    std::istream& in_;
+    int default_k_;
+    std::size_t count_ = 0;
+    bool detected_ = false;
+    bool jsonl_ = false;
+
+    void detect() {
+        detected_ = true;
+        while (true) {
+            int ch = in_.peek();
+            if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+                in_.get();
+                continue;
+            }
+            jsonl_ = (ch == '{');
+            return;
+        }
+    }
+
+    static void strip_cr(string& s) {
+        if (!s.empty() && s.back() == '\r') s.pop_back();
+    }
+
+    bool next_jsonl(Puzzle& p) {
+        string line;
+        while (std::getline(in_, line)) {
+            strip_cr(line);
+            if (line.find_first_not_of(" \t") == string::npos) continue;
+            try {
+                read_record(json::parse(line), p);
+            } catch (const std::exception& e) {
+                p.error = e.what();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool next_ascii(Puzzle& p) {
+        string line;
+        while (std::getline(in_, line)) {
+            strip_cr(line);
+            if (line.empty()) {
+                if (p.grid.empty()) continue;
+                return true;
+            }
+            p.grid.push_back(line);
+        }
+        return !p.grid.empty();
+    }
+};
+
+// Boards of a mapped corpus, in file order; grids stay in the mapping
+class CorpusReader {
+public:
+    explicit CorpusReader(const Corpus& corpus) : corpus_(corpus) {}
+
+    bool next(Puzzle& p) {
+        if (next_ >= corpus_.size()) return false;
+        p = Puzzle();
+        p.index = next_;
+        try {
+            CorpusBoard b = corpus_.at(next_);
+            p.k = b.k;
+            p.packed = b.grid;
+            if (p.packed.R == 0 || p.packed.C == 0) p.error = "Empty grid";
+        } catch (const std::exception& e) {
+            p.error = e.what();
+        }
+        next_++;
+        return true;
+    }
+
+private:
+    const Corpus& corpus_;
+    std::size_t next_ = 0;
+};
+
+/* ---------------- Output ---------------- */
+
+inline void write_walls(std::ostream& os, const vector<std::pair<int,int>>& walls) {
+    os << "[";
+    for (std::size_t i = 0; i < walls.size(); i++) {
+        if (i) os << ",";
+        os << "[" << walls[i].first << "," << walls[i].second << "]";
+    }
+    os << "]";
+}
+
+inline void write_stats(std::ostream& os, const SolveStats& st) {
+    os << "{";
+    bool first = true;
+    st.for_each([&](const char* name, auto value) {
+        if (!first) os << ",";
+        first = false;
+        os << "\"" << name << "\":" << value;
+    });
+    os << "}";
+}
+
+inline string format_result(const Puzzle& p, const SolveResult& res, double ms) {
+    std::ostringstream os;
+    os << "{\"index\":" << p.index;
+    if (!p.id.is_null()) {
+        os << ",\"id\":";
+        json::write(os, p.id);
+    }
+    os << ",\"k\":" << p.k << ",\"area\":" << res.best_area << ",\"walls\":";
+    write_walls(os, res.walls);
+    os << ",\"time_ms\":" << ms;
+    if (res.has_stats) {
+        os << ",\"stats\":";
+        write_stats(os, res.stats);
+    }
+    os << "}";
+    return os.str();
+}
+
+inline string format_error(const Puzzle& p, const string& msg) {
+    std::ostringstream os;
+    os << "{\"index\":" << p.index;
+    if (!p.id.is_null()) {
+        os << ",\"id\":";
+        json::write(os, p.id);
+    }
+    os << ",\"error\":" << json::quote(msg) << "}";
+    return os.str();
+}
+
+/* ---------------- Runner ---------------- */
+
+enum class OutputOrder { Input, Completion };
+
+struct Options {
+    int threads = 1;
+    int default_k = 6;
+    OutputOrder order = OutputOrder::Input;
+    ResultStore* store = nullptr;   // optional persistent result cache
+    bool collect_stats = false;     // add a "stats" object to each result
+    TraceRecorder* trace = nullptr; // timeline of every solve, one track per worker
+    CellOrder cell_order = CellOrder::Bfs;
+    bool learn_nogoods = false;
+    Branching branching = Branching::MinCuts;
+    FlowEngine flow_engine = FlowEngine::Auto;
+};
+
+struct Summary {
+    std::size_t puzzles = 0;
+    std::size_t failed = 0;
+    double wall_ms = 0.0;
+};
+
+// Writes results in input or completion order. Input order buffers results
+// that finish ahead of earlier puzzles; admit() keeps that buffer to
+// `window` entries by holding the reader back until the oldest unwritten
+// puzzle is within `window` of the next one.
+class ResultSink {
+public:
+    ResultSink(std::ostream& out, OutputOrder order, std::size_t window)
+        : out_(out), order_(order), window_(window) {}
+
+    // Blocks until puzzle `index` may be submitted
+    void admit(std::size_t index) {
+        if (order_ == OutputOrder::Completion) return;
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&] { return index < next_ + window_; });
+    }
+
+    void emit(std::size_t index, string line) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (order_ == OutputOrder::Completion) {
+            out_ << line << "\n";
+            out_.flush();
+            return;
+        }
+        pending_[index] = std::move(line);
+        bool wrote = false;
+        for (auto it = pending_.find(next_); it != pending_.end(); it = pending_.find(next_)) {
+            out_ << it->second << "\n";
+            pending_.erase(it);
+            next_++;
+            wrote = true;
+        }
+        if (wrote) {
+            out_.flush();
+            cv_.notify_all();
+        }
+    }
+
+private:
+    std::ostream& out_;
+    OutputOrder order_;
+    std::size_t window_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::map<std::size_t, string> pending_;
+    std::size_t next_ = 0;
+};
+
+// Solves every puzzle `reader` yields (PuzzleReader or CorpusReader)
+template <class Reader>
+Summary run_reader(Reader& reader, std::ostream& out, const Options& opt) {
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+
+    const std::size_t window = static_cast<std::size_t>(std::max(opt.threads, 1)) * 4;
+    ResultSink sink(out, opt.order, window);
+    std::mutex stat_mu;
+    Summary summary;
+
+    {
+        ThreadPool pool(opt.threads, window);
+        Puzzle p;
+        while (reader.next(p)) {
+            summary.puzzles++;
+            sink.admit(p.index);
+            ResultStore* store = opt.store;
+            SolveOptions sopt;
+            sopt.collect_stats = opt.collect_stats;
+            sopt.trace = opt.trace;
+            sopt.cell_order = opt.cell_order;
+            sopt.learn_nogoods = opt.learn_nogoods;
+            sopt.branching = opt.branching;
+            sopt.flow_engine = opt.flow_engine;
+            pool.submit([p, store, sopt, &sink, &stat_mu, &summary]() {
+                string line;
+                bool failed = false;
+                if (!p.error.empty()) {
+                    line = format_error(p, p.error);
+                    failed = true;
+                } else {
+                    try {
+                        TraceScope span(sopt.trace, "puzzle", "batch",
+                                        sopt.trace ? "\"index\":" + std::to_string(p.index) : string());
+                        auto s = clock::now();
+                        SolveResult res;
+                        if (p.packed.R > 0) {
+                            res = store ? solve_cached(p.k, p.packed.to_rows(), sopt, *store)
+                                        : solve(p.k, p.packed, sopt);
+                        } else {
+                            res = store ? solve_cached(p.k, p.grid, sopt, *store)
+                                        : solve(p.k, p.grid, sopt);
+                        }
+                        double ms = std::chrono::duration<double, std::milli>(clock::now() - s).count();
+                        line = format_result(p, res, ms);
+                    } catch (const std::exception& e) {
+                        line = format_error(p, e.what());
+                        failed = true;
+                    }
+                }
+                if (failed) {
+                    std::lock_guard<std::mutex> lk(stat_mu);
+                    summary.failed++;
+                }
+                sink.emit(p.index, std::move(line));
+            });
+        }
+        pool.wait_idle();
+    }
+
+    summary.wall_ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+    return summary;
+}
+
+inline Summary run(std::istream& in, std::ostream& out, const Options& opt) {
+    PuzzleReader reader(in, opt.default_k);
+    return run_reader(reader, out, opt);
+}
+
+// Batch over a binary corpus; each record carries its own k
+inline Summary run_corpus(const Corpus& corpus, std::ostream& out, const Options& opt) {
+    CorpusReader reader(corpus);
+    return run_reader(reader, out, opt);
+}
+
+} // namespace batch
+} // namespace enclose
@@ -0,0 +1,474 @@
+// bench.cpp - Benchmark harness over the curated corpus in bench/corpus
+// Compile with: clang++ -O2 -std=c++17 -o bench bench.cpp
+//
+// Runs enclose::solve repeatedly per (board, k) after warmup and reports
+// median / p95 time, nodes/sec and memory as CSV or JSON. With --baseline it
+// compares against a previous JSON report and exits non-zero on regressions.
+// --sweep replaces the corpus with generated boards over a size x k grid.
+// Where perf_event_open is permitted, hardware counters are read around the
+// timed runs and reported per solve and per search node.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "generator.hpp"
+#include "json.hpp"
+#include "perf_counters.hpp"
+#include "solver.hpp"
+
+using std::string;
+using std::vector;
+
+/* ---------------- Corpus ---------------- */
+
+struct BenchCase {
+    string name;
+    int k = 0;
+    vector<string> grid;
+};
+
+vector<string> read_grid_file(const string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    vector<string> grid;
+    string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) grid.push_back(line);
+    }
+    return grid;
+}
+
+// index.txt lists "<board> <k>" per line; '#' starts a comment
+vector<BenchCase> load_corpus(const string& dir) {
+    std::ifstream in(dir + "/index.txt");
+    if (!in) throw std::runtime_error("cannot open " + dir + "/index.txt");
+    vector<BenchCase> cases;
+    std::map<string, vector<string>> boards;
+    string line;
+    while (std::getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        std::istringstream is(line);
+        string board;
+        int k = 0;
+        if (!(is >> board >> k)) continue;
+        auto it = boards.find(board);
+        if (it == boards.end()) it = boards.emplace(board, read_grid_file(dir + "/" + board + ".txt")).first;
+        BenchCase bc;
+        bc.name = board;
+        bc.k = k;
+        bc.grid = it->second;
+        cases.push_back(std::move(bc));
+    }
+    return cases;
+}
+
+vector<int> parse_int_list(const string& s) {
+    vector<int> out;
+    std::istringstream is(s);
+    string item;
+    while (std::getline(is, item, ',')) {
+        if (!item.empty()) out.push_back(std::stoi(item));
+    }
+    return out;
+}
+
+struct SweepSpec {
+    vector<int> sizes{10, 20, 50, 100, 200};
+    vector<int> ks{2, 5, 10, 20};
+    enclose::gen::Params params;
+};
+
+// One generated board per size, paired with every k
+vector<BenchCase> sweep_cases(const SweepSpec& spec) {
+    const char* layout = spec.params.layout == enclose::gen::Layout::Clustered ? "clustered"
+                       : spec.params.layout == enclose::gen::Layout::Corridors ? "corridors" : "uniform";
+    vector<BenchCase> cases;
+    for (int size : spec.sizes) {
+        enclose::gen::Params p = spec.params;
+        p.rows = p.cols = size;
+        vector<string> grid = enclose::gen::generate(p);
+        for (int k : spec.ks) {
+            BenchCase bc;
+            bc.name = "sweep_" + string(layout) + "_" + std::to_string(size) + "x" + std::to_string(size);
+            bc.k = k;
+            bc.grid = grid;
+            cases.push_back(std::move(bc));
+        }
+    }
+    return cases;
+}
+
+/* ---------------- Measurement ---------------- */
+
+struct BenchResult {
+    string name;
+    int k = 0;
+    int rows = 0, cols = 0;
+    int area = 0;
+    int runs = 0;
+    double median_ms = 0.0;
+    double p95_ms = 0.0;
+    double min_ms = 0.0;
+    uint64_t nodes = 0;
+    double nodes_per_sec = 0.0;
+    uint64_t memo_bytes = 0;
+    long peak_rss_kb = 0;
+    bool timed_out = false;   // the instrumented run hit --timeout-ms; no timed runs
+    enclose::PerfSample perf; // mean per timed run; events invalid if unavailable
+};
+
+// Per-case peak RSS: reset_peak_rss() drops the kernel's high-water mark
+// (VmHWM) to the current RSS, so peak_rss_kb() covers only what ran since.
+// ru_maxrss cannot be reset, so without /proc (non-Linux) both give up and
+// the column reads 0 rather than the largest case so far.
+bool reset_peak_rss() {
+    std::ofstream f("/proc/self/clear_refs");
+    f << "5";
+    f.flush();
+    return static_cast<bool>(f);
+}
+
+long peak_rss_kb() {
+    std::ifstream f("/proc/self/status");
+    string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atol(line.c_str() + 6);
+    }
+    return 0;
+}
+
+// Nearest-rank percentile of a sorted sample
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    if (rank == 0) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+BenchResult run_case(const BenchCase& bc, int warmup, int runs, double timeout_ms,
+                     enclose::PerfCounters* perf, const enclose::SolveOptions& base_opt) {
+    using clock = std::chrono::steady_clock;
+
+    BenchResult r;
+    r.name = bc.name;
+    r.k = bc.k;
+    r.rows = static_cast<int>(bc.grid.size());
+    r.cols = static_cast<int>(bc.grid[0].size());
+    r.runs = runs;
+    const bool rss_reset = reset_peak_rss();
+
+    // One instrumented run for the counters; timed runs use the plain search
+    enclose::SolveOptions stats_opt = base_opt;
+    stats_opt.collect_stats = true;
+    if (timeout_ms > 0) {
+        stats_opt.deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double, std::milli>(timeout_ms));
+    }
+    enclose::SolveResult sres = enclose::solve(bc.k, bc.grid, stats_opt);
+    r.area = sres.best_area;
+    r.nodes = sres.stats.nodes;
+    r.memo_bytes = sres.stats.memo_bytes;
+    r.peak_rss_kb = rss_reset ? peak_rss_kb() : 0;
+    if (sres.timed_out) {
+        r.timed_out = true;
+        r.runs = 0;
+        r.median_ms = r.p95_ms = r.min_ms = sres.stats.search_ms;
+        return r;
+    }
+
+    for (int i = 0; i < warmup; i++) enclose::solve(bc.k, bc.grid, base_opt);
+
+    vector<double> times;
+    times.reserve(static_cast<size_t>(runs));
+    if (perf) {
+        for (int e = 0; e < enclose::PERF_EVENT_COUNT; e++) r.perf.valid[e] = perf->available(e);
+    }
+    for (int i = 0; i < runs; i++) {
+        if (perf) perf->start();
+        auto t0 = clock::now();
+        enclose::SolveResult res = enclose::solve(bc.k, bc.grid, base_opt);
+        times.push_back(std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+        if (perf) {
+            enclose::PerfSample s = perf->stop();
+            for (int e = 0; e < enclose::PERF_EVENT_COUNT; e++) {
+                r.perf.valid[e] = r.perf.valid[e] && s.valid[e];
+                r.perf.value[e] += s.value[e] / runs;
+            }
+        }
+        if (res.best_area != r.area) {
+            throw std::runtime_error(bc.name + ": nondeterministic result");
+        }
+    }
+    std::sort(times.begin(), times.end());
+    r.median_ms = percentile(times, 0.5);
+    r.p95_ms = percentile(times, 0.95);
+    r.min_ms = times.front();
+    r.nodes_per_sec = r.median_ms > 0 ? static_cast<double>(r.nodes) / (r.median_ms / 1000.0) : 0.0;
+    r.peak_rss_kb = rss_reset ? peak_rss_kb() : 0;
+    return r;
+}
+
+/* ---------------- Output ---------------- */
+
+double per_node(const BenchResult& r, int e) {
+    return r.nodes ? r.perf.value[e] / static_cast<double>(r.nodes) : 0.0;
+}
+
+bool has_ipc(const BenchResult& r) {
+    return r.perf.valid[enclose::PERF_CYCLES] && r.perf.valid[enclose::PERF_INSTRUCTIONS] &&
+           r.perf.value[enclose::PERF_CYCLES] > 0;
+}
+
+double ipc(const BenchResult& r) {
+    return r.perf.value[enclose::PERF_INSTRUCTIONS] / r.perf.value[enclose::PERF_CYCLES];
+}
+
+// Counter columns are left empty when the event is unavailable
+void write_csv(std::ostream& os, const vector<BenchResult>& results) {
+    os << "name,k,rows,cols,area,runs,median_ms,p95_ms,min_ms,nodes,nodes_per_sec,memo_bytes,peak_rss_kb,timed_out";
+    for (int e = 0; e < enclose::PERF_EVENT_COUNT; e++) {
+        os << "," << enclose::perf_event_name(e) << "," << enclose::perf_event_name(e) << "_per_node";
+    }
+    os << ",ipc\n";
+    for (const auto& r : results) {
+        os << r.name << "," << r.k << "," << r.rows << "," << r.cols << "," << r.area << "," << r.runs << ","
+           << r.median_ms << "," << r.p95_ms << "," << r.min_ms << "," << r.nodes << ","
+           << static_cast<uint64_t>(r.nodes_per_sec) << "," << r.memo_bytes << "," << r.peak_rss_kb << ","
+           << (r.timed_out ? 1 : 0);
+        for (int e = 0; e < enclose::PERF_EVENT_COUNT; e++) {
+            if (r.perf.valid[e]) os << "," << static_cast<uint64_t>(r.perf.value[e]) << "," << per_node(r, e);
+            else os << ",,";
+        }
+        os << ",";
+        if (has_ipc(r)) os << ipc(r);
+        os << "\n";
+    }
+}
+
+void write_json(std::ostream& os, const vector<BenchResult>& results) {
+    os << "{\"results\":[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        os << "  {\"name\":" << enclose::json::quote(r.name) << ",\"k\":" << r.k
+           << ",\"rows\":" << r.rows << ",\"cols\":" << r.cols << ",\"area\":" << r.area
+           << ",\"runs\":" << r.runs << ",\"median_ms\":" << r.median_ms << ",\"p95_ms\":" << r.p95_ms
+           << ",\"min_ms\":" << r.min_ms << ",\"nodes\":" << r.nodes
+           << ",\"nodes_per_sec\":" << static_cast<uint64_t>(r.nodes_per_sec)
+           << ",\"memo_bytes\":" << r.memo_bytes << ",\"peak_rss_kb\":" << r.peak_rss_kb
+           << ",\"timed_out\":" << (r.timed_out ? "true" : "false") << ",\"perf\":{";
+        bool first = true;
+        for (int e = 0; e < enclose::PERF_EVENT_COUNT; e++) {
+            if (!r.perf.valid[e]) continue;
+            os << (first ? "" : ",") << "\"" << enclose::perf_event_name(e) << "\":"
+               << static_cast<uint64_t>(r.perf.value[e]) << ",\"" << enclose::perf_event_name(e)
+               << "_per_node\":" << per_node(r, e);
+            first = false;
+        }
+        if (has_ipc(r)) os << ",\"ipc\":" << ipc(r);
+        os << "}}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "]}\n";
+}
+
+/* ---------------- Baseline comparison ---------------- */
+
+// Returns the number of regressions: median, memo_bytes or peak_rss_kb above
+// baseline by more than threshold (fraction), or a different best area (a
+// correctness failure). A memory figure of 0 on either side was not measured.
+int compare_baseline(const string& path, const vector<BenchResult>& results, double threshold) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open baseline " + path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    enclose::json::Value base = enclose::json::parse(ss.str());
+    const enclose::json::Value* arr = base.find("results");
+    if (!arr || !arr->is_array()) throw std::runtime_error("baseline has no \"results\" array");
+
+    std::map<std::pair<string, int>, const enclose::json::Value*> by_key;
+    for (const auto& v : arr->arr) {
+        const enclose::json::Value* name = v.find("name");
+        const enclose::json::Value* k = v.find("k");
+        int kv = 0;
+        if (name && k && enclose::json::get_int(*k, 0, std::numeric_limits<int>::max(), kv)) by_key[{name->str, kv}] = &v;
+    }
+
+    int regressions = 0;
+    std::cerr << "baseline " << path << " (threshold " << threshold * 100 << "%):\n";
+    for (const auto& r : results) {
+        auto it = by_key.find({r.name, r.k});
+        if (it == by_key.end()) {
+            std::cerr << "  " << r.name << " k=" << r.k << ": not in baseline\n";
+            continue;
+        }
+        const enclose::json::Value* bmed = it->second->find("median_ms");
+        const enclose::json::Value* barea = it->second->find("area");
+        double base_ms = bmed ? bmed->num : 0.0;
+        double change = base_ms > 0 ? r.median_ms / base_ms - 1.0 : 0.0;
+        string verdict = "ok";
+        const enclose::json::Value* btimeout = it->second->find("timed_out");
+        if (r.timed_out || (btimeout && btimeout->b)) {
+            std::cerr << "  " << r.name << " k=" << r.k << ": timed out, not compared\n";
+            continue;
+        }
+        // Memory against the same threshold, listed after the verdict
+        string memory;
+        auto compare_memory = [&](const char* field, double now) {
+            const enclose::json::Value* b = it->second->find(field);
+            if (!b || !b->is_number() || !(b->num > 0) || now <= 0) return;
+            double c = now / b->num - 1.0;
+            if (c <= threshold) return;
+            std::ostringstream ms;
+            ms << " " << field << " " << b->num << " -> " << now << " (+" << c * 100 << "%)";
+            memory += ms.str();
+        };
+        compare_memory("memo_bytes", static_cast<double>(r.memo_bytes));
+        compare_memory("peak_rss_kb", static_cast<double>(r.peak_rss_kb));
+
+        int base_area = 0;
+        if (barea && (!enclose::json::get_int(*barea, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), base_area) || base_area != r.area)) {
+            std::ostringstream bs;
+            enclose::json::write(bs, *barea);
+            verdict = "WRONG AREA (baseline " + bs.str() + ")";
+            regressions++;
+        } else if (change > threshold || !memory.empty()) {
+            verdict = (change > threshold ? "REGRESSION" : "MEMORY REGRESSION") + memory;
+            regressions++;
+        } else if (change < -threshold) {
+            verdict = "faster";
+        }
+        std::cerr << "  " << r.name << " k=" << r.k << ": " << base_ms << " -> " << r.median_ms << " ms ("
+                  << (change >= 0 ? "+" : "") << change * 100 << "%) " << verdict << "\n";
+    }
+    return regressions;
+}
+
+/* ---------------- main ---------------- */
+
+int main(int argc, char** argv) {
+    string corpus = "bench/corpus";
+    string format = "csv";
+    string out_path;
+    string baseline;
+    string filter;
+    int warmup = 1;
+    int runs = 5;
+    double threshold = 0.10;
+    double timeout_ms = 0.0;
+    bool sweep = false;
+    bool use_perf = true;
+    enclose::SolveOptions solve_opt;
+    SweepSpec spec;
+    spec.params.layout = enclose::gen::Layout::Clustered;
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--corpus" && i + 1 < argc) {
+            corpus = argv[++i];
+        } else if (a == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (a == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (a == "--baseline" && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (a == "--threshold" && i + 1 < argc) {
+            threshold = std::stod(argv[++i]) / 100.0;
+        } else if (a == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (a == "--warmup" && i + 1 < argc) {
+            warmup = std::stoi(argv[++i]);
+        } else if (a == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else if (a == "--timeout-ms" && i + 1 < argc) {
+            timeout_ms = std::stod(argv[++i]);
+        } else if (a == "--cell-order" && i + 1 < argc && enclose::parse_cell_order(argv[i + 1], solve_opt.cell_order)) {
+            i++;
+        } else if (a == "--branching" && i + 1 < argc && enclose::parse_branching(argv[i + 1], solve_opt.branching)) {
+            i++;
+        } else if (a == "--flow-engine" && i + 1 < argc && enclose::parse_flow_engine(argv[i + 1], solve_opt.flow_engine)) {
+            i++;
+        } else if (a == "--no-perf") {
+            use_perf = false;
+        } else if (a == "--sweep") {
+            sweep = true;
+        } else if (a == "--sizes" && i + 1 < argc) {
+            spec.sizes = parse_int_list(argv[++i]);
+        } else if (a == "--ks" && i + 1 < argc) {
+            spec.ks = parse_int_list(argv[++i]);
+        } else if (a == "--water" && i + 1 < argc) {
+            spec.params.water = std::stod(argv[++i]);
+        } else if (a == "--seed" && i + 1 < argc) {
+            spec.params.seed = std::stoull(argv[++i]);
+        } else if (a == "--layout" && i + 1 < argc && enclose::gen::parse_layout(argv[i + 1], spec.params.layout)) {
+            i++;
+        } else {
+            std::cerr << "usage: bench [--corpus DIR] [--runs N] [--warmup N] [--format csv|json] [--out FILE]\n"
+                         "             [--filter SUBSTR] [--baseline FILE.json] [--threshold PCT] [--timeout-ms T] [--no-perf]\n"
+                         "             [--cell-order bfs|row-major|morton|hilbert] [--branching sink-cut|min-cuts]\n"
+                         "             [--flow-engine auto|ek|bk|pr]\n"
+                         "       bench --sweep [--sizes 10,20,50,100,200] [--ks 2,5,10,20] [--water F]\n"
+                         "             [--layout uniform|clustered|corridors] [--seed S] [--timeout-ms T] ...\n";
+            return 2;
+        }
+    }
+    if (format != "csv" && format != "json") {
+        std::cerr << "unknown --format: " << format << "\n";
+        return 2;
+    }
+
+    if (sweep && timeout_ms <= 0) timeout_ms = 10000.0;
+
+    std::unique_ptr<enclose::PerfCounters> perf;
+    if (use_perf) {
+        perf.reset(new enclose::PerfCounters());
+        if (!perf->error().empty()) {
+            std::cerr << "perf counters " << (perf->any_available() ? "partly " : "") << "unavailable: "
+                      << perf->error() << "\n";
+        }
+        if (!perf->any_available()) perf.reset();
+    }
+
+    try {
+        vector<BenchCase> cases = sweep ? sweep_cases(spec) : load_corpus(corpus);
+        vector<BenchResult> results;
+        string timed_out_board;   // in a sweep, larger k on a board that timed out is skipped
+        for (const auto& bc : cases) {
+            if (!filter.empty() && bc.name.find(filter) == string::npos) continue;
+            if (sweep && bc.name == timed_out_board) {
+                std::cerr << bc.name << " k=" << bc.k << ": skipped (smaller k timed out)\n";
+                continue;
+            }
+            BenchResult r = run_case(bc, warmup, runs, timeout_ms, perf.get(), solve_opt);
+            if (r.timed_out) timed_out_board = bc.name;
+            std::cerr << r.name << " k=" << r.k << ": median " << r.median_ms << " ms, p95 " << r.p95_ms
+                      << " ms, " << r.nodes << " nodes";
+            if (has_ipc(r)) std::cerr << ", IPC " << ipc(r);
+            std::cerr << "\n";
+            results.push_back(std::move(r));
+        }
+
+        std::ofstream file;
+        if (!out_path.empty()) file.open(out_path);
+        std::ostream& os = out_path.empty() ? std::cout : file;
+        if (format == "csv") write_csv(os, results);
+        else write_json(os, results);
+
+        if (!baseline.empty() && compare_baseline(baseline, results, threshold) > 0) return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "bench: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
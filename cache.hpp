@@ -0,0 +1,348 @@
+#pragma once
+
+// cache.hpp - Result caching keyed by a canonical form of the grid
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "solver.hpp"
+
+namespace enclose {
+
+/* ---------------- Canonical grid ---------------- */
+
+// Cell as the solver sees it: 'H', '.', and '#' for every other (blocked) character.
+// Rows shorter than the first one are padded with '#'.
+inline char canonical_cell(const vector<string>& grid, int r, int c) {
+    const string& row = grid[static_cast<size_t>(r)];
+    char ch = static_cast<size_t>(c) < row.size() ? row[static_cast<size_t>(c)] : '#';
+    return (ch == 'H' || ch == '.') ? ch : '#';
+}
+
+// The 8 dihedral symmetries of a rectangle. Bit 2 transposes, then bit 0 flips
+// rows and bit 1 flips columns of the (possibly transposed) grid.
+inline pair<int,int> sym_apply(int sym, int r, int c, int R, int C) {
+    if (sym & 4) { std::swap(r, c); std::swap(R, C); }
+    if (sym & 1) r = R - 1 - r;
+    if (sym & 2) c = C - 1 - c;
+    return {r, c};
+}
+
+// Inverse of sym_apply; R and C are the dimensions before the transform.
+inline pair<int,int> sym_invert(int sym, int r, int c, int R, int C) {
+    if (sym & 4) std::swap(R, C);
+    if (sym & 2) c = C - 1 - c;
+    if (sym & 1) r = R - 1 - r;
+    if (sym & 4) std::swap(r, c);
+    return {r, c};
+}
+
+inline uint64_t hash_bytes(const std::string& s) {
+    uint64_t h = splitmix64(static_cast<uint64_t>(s.size()));
+    for (unsigned char ch : s) h = splitmix64(h ^ ch);
+    return h;
+}
+
+struct CanonicalGrid {
+    std::string text;   // rows of the canonical orientation, each terminated by '\n'
+    uint64_t hash = 0;
+    int rows = 0, cols = 0;   // dimensions of the original grid
+    int sym = 0;              // transform taking the original grid to the canonical one
+
+    // Map walls between original and canonical coordinates (result is sorted)
+    vector<pair<int,int>> to_canonical(const vector<pair<int,int>>& walls) const {
+        vector<pair<int,int>> out;
+        out.reserve(walls.size());
+        for (const auto& w : walls) out.push_back(sym_apply(sym, w.first, w.second, rows, cols));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+    vector<pair<int,int>> from_canonical(const vector<pair<int,int>>& walls) const {
+        vector<pair<int,int>> out;
+        out.reserve(walls.size());
+        for (const auto& w : walls) out.push_back(sym_invert(sym, w.first, w.second, rows, cols));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+};
+
+// Pick the lexicographically smallest rendering among the 8 symmetric images,
+// so rotated or mirrored copies of a board share one cache entry.
+inline CanonicalGrid canonicalize(const vector<string>& grid) {
+    CanonicalGrid cg;
+    if (grid.empty()) return cg;
+    int R = static_cast<int>(grid.size());
+    int C = static_cast<int>(grid[0].size());
+    cg.rows = R;
+    cg.cols = C;
+
+    std::string cand;
+    for (int sym = 0; sym < 8; sym++) {
+        int R2 = (sym & 4) ? C : R;
+        int C2 = (sym & 4) ? R : C;
+        cand.clear();
+        cand.reserve(static_cast<size_t>(R2) * static_cast<size_t>(C2 + 1));
+        for (int r = 0; r < R2; r++) {
+            for (int c = 0; c < C2; c++) {
+                pair<int,int> src = sym_invert(sym, r, c, R, C);
+                cand += canonical_cell(grid, src.first, src.second);
+            }
+            cand += '\n';
+        }
+        if (sym == 0 || cand < cg.text) {
+            cg.text = cand;
+            cg.sym = sym;
+        }
+    }
+    cg.hash = hash_bytes(cg.text);
+    return cg;
+}
+
+struct CacheKey {
+    uint64_t hash = 0;
+    std::string grid;   // canonical text, compared on lookup to rule out collisions
+    int k = 0;
+
+    bool operator==(const CacheKey& o) const {
+        return hash == o.hash && k == o.k && grid == o.grid;
+    }
+};
+
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const noexcept {
+        return static_cast<size_t>(key.hash ^ splitmix64(static_cast<uint64_t>(key.k)));
+    }
+};
+
+inline CacheKey make_cache_key(const CanonicalGrid& cg, int k) {
+    CacheKey key;
+    key.grid = cg.text;
+    key.hash = cg.hash;
+    key.k = k;
+    return key;
+}
+
+/* ---------------- LruCache ---------------- */
+
+// Thread-safe in-memory LRU map from (canonical grid, k) to a finished result.
+// Stored walls are in canonical coordinates.
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+    bool get(const CacheKey& key, SolveResult& out) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            misses_++;
+            return false;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        out = it->second->second;
+        hits_++;
+        return true;
+    }
+
+    void put(const CacheKey& key, const SolveResult& value) {
+        if (capacity_ == 0) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = value;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        entries_.emplace_front(key, value);
+        index_[key] = entries_.begin();
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return entries_.size();
+    }
+    void clear() {
+        std::lock_guard<std::mutex> lk(mu_);
+        entries_.clear();
+        index_.clear();
+    }
+    uint64_t hits() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return hits_;
+    }
+    uint64_t misses() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return misses_;
+    }
+
+private:
+    using Entry = std::pair<CacheKey, SolveResult>;
+
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<CacheKey, std::list<Entry>::iterator, CacheKeyHash> index_;
+    std::mutex mu_;
+    uint64_t hits_ = 0, misses_ = 0;
+};
+
+/* ---------------- ResultStore ---------------- */
+
+// Persistent (canonical grid, k) -> (area, walls) store backed by an append-only
+// log file, one record per line:
+//   E1 <hash> <k> <area> <rows joined by '/'> <nwalls> <r> <c> ...
+// The in-memory index maps (hash, k) to record offsets and is rebuilt by
+// scanning the log on open. A torn trailing record is truncated away. An empty
+// path gives a memory-only store of the MEMORY_ENTRIES most recent results
+// (used by the WASM build).
+class ResultStore {
+public:
+    // Results kept by a memory-only store, least recently used dropped first
+    static constexpr size_t MEMORY_ENTRIES = 4096;
+
+    ResultStore() = default;
+    explicit ResultStore(const std::string& path) { open(path); }
+
+    // Returns false if the log cannot be opened for appending
+    bool open(const std::string& path) {
+        std::lock_guard<std::mutex> lk(mu_);
+        path_ = path;
+        index_.clear();
+        memory_.clear();
+        if (path_.empty()) return true;
+
+        std::ifstream in(path_, std::ios::binary);
+        std::streamoff off = 0;   // just past the last complete line
+        bool torn = false;
+        if (in) {
+            std::string line;
+            while (std::getline(in, line)) {
+                if (in.eof()) {
+                    torn = true;
+                    break;
+                }
+                CacheKey key;
+                SolveResult res;
+                if (parse_record(line, key, res)) index_[slot(key.hash, key.k)].push_back(off);
+                off += static_cast<std::streamoff>(line.size()) + 1;
+            }
+            in.close();
+        }
+        // Cut a torn record off, or the next append would extend it
+        if (torn) {
+            std::error_code ec;
+            std::filesystem::resize_file(path_, static_cast<std::uintmax_t>(off), ec);
+            if (ec) return false;
+        }
+        out_.open(path_, std::ios::binary | std::ios::app);
+        return static_cast<bool>(out_);
+    }
+
+    bool get(const CacheKey& key, SolveResult& out) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (path_.empty()) return memory_.get(key, out);
+        auto it = index_.find(slot(key.hash, key.k));
+        if (it == index_.end()) return false;
+        std::ifstream in(path_, std::ios::binary);
+        std::string line;
+        for (std::streamoff off : it->second) {
+            in.clear();
+            in.seekg(off);
+            if (!std::getline(in, line)) continue;
+            CacheKey k2;
+            SolveResult res;
+            if (parse_record(line, k2, res) && k2 == key) {
+                out = std::move(res);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Walls must be in canonical coordinates
+    void put(const CacheKey& key, const SolveResult& value) {
+        if (value.timed_out) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (path_.empty()) {
+            memory_.put(key, value);
+            return;
+        }
+        if (!out_) return;
+        std::ostringstream rec;
+        rec << "E1 " << std::hex << key.hash << std::dec << " " << key.k << " " << value.best_area << " ";
+        for (char ch : key.grid) rec << (ch == '\n' ? '/' : ch);
+        rec << " " << value.walls.size();
+        for (const auto& w : value.walls) rec << " " << w.first << " " << w.second;
+        rec << "\n";
+
+        out_.seekp(0, std::ios::end);
+        std::streamoff off = static_cast<std::streamoff>(out_.tellp());
+        out_ << rec.str();
+        out_.flush();
+        index_[slot(key.hash, key.k)].push_back(off);
+    }
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    std::unordered_map<uint64_t, vector<std::streamoff>> index_;
+    LruCache memory_{MEMORY_ENTRIES};
+    std::mutex mu_;
+
+    static uint64_t slot(uint64_t hash, int k) {
+        return hash ^ splitmix64(static_cast<uint64_t>(k));
+    }
+
+    static bool parse_record(const std::string& line, CacheKey& key, SolveResult& res) {
+        std::istringstream is(line);
+        std::string tag, rows;
+        size_t nwalls = 0;
+        if (!(is >> tag) || tag != "E1") return false;
+        if (!(is >> std::hex >> key.hash >> std::dec >> key.k >> res.best_area >> rows >> nwalls)) return false;
+        key.grid.clear();
+        for (char ch : rows) key.grid += (ch == '/' ? '\n' : ch);
+        // a damaged count must not size the vector: no answer walls more cells than the grid has
+        size_t cells = rows.size() - static_cast<size_t>(std::count(rows.begin(), rows.end(), '/'));
+        if (nwalls > cells) return false;
+        res.walls.resize(nwalls);
+        for (auto& w : res.walls) {
+            if (!(is >> w.first >> w.second)) return false;
+        }
+        return true;
+    }
+};
+
+// Solve through a store: a hit skips the search entirely and maps the stored
+// walls back through the board's symmetry; a miss solves and records the result.
+inline SolveResult solve_cached(int k, const vector<string>& grid, const SolveOptions& opt,
+                                ResultStore& store, bool* hit = nullptr) {
+    CanonicalGrid cg = canonicalize(grid);
+    CacheKey key = make_cache_key(cg, k);
+    SolveResult res;
+    if (store.get(key, res)) {
+        res.walls = cg.from_canonical(res.walls);
+        if (hit) *hit = true;
+        return res;
+    }
+    if (hit) *hit = false;
+    res = solve(k, grid, opt);
+    SolveResult stored = res;
+    stored.walls = cg.to_canonical(res.walls);
+    store.put(key, stored);
+    return res;
+}
+
+} // namespace enclose
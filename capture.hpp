@@ -0,0 +1,158 @@
+#pragma once
+
+// capture.hpp - Save / load KernelCapture files for microbenchmark replay
+//
+// Format (text, whitespace separated):
+//   enclose-capture 1
+//   k <k>
+//   grid <rows> <cols>
+//   <row> x rows
+//   flow <count>
+//   <k_rem> <n_deleted> (<r> <c>)... <n_forced> (<r> <c>)...   x count
+//   bfs <count>
+//   <n_blocked> (<r> <c>)...                                    x count
+//   reach <count>
+//   b <r> <c> | u | a <n_walls> (<r> <c>)...                    x count
+// Cells are stored as grid coordinates so a capture stays valid however the
+// solver numbers cells internally. Version 1 files (no reach section) are
+// still read.
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "solver.hpp"
+
+namespace enclose {
+
+struct CaptureFile {
+    int k = 0;
+    vector<string> grid;
+    KernelCapture kernels;
+};
+
+namespace detail {
+
+inline void write_cells(std::ostream& os, const DynamicBitset& bits, const CellGraph& g) {
+    os << bits.popcount();
+    bits.for_each_set_bit([&](int i) {
+        os << " " << g.coords[static_cast<size_t>(i)].first << " " << g.coords[static_cast<size_t>(i)].second;
+    });
+}
+
+// id_of maps r * C + c to the cell id (-1 outside the graph)
+inline int read_cell(std::istream& is, const CellGraph& g, const vector<int>& id_of) {
+    long long r = 0, c = 0;
+    if (!(is >> r >> c)) throw std::runtime_error("capture: truncated cell list");
+    if (r < 0 || r >= g.R || c < 0 || c >= g.C || id_of[static_cast<size_t>(r * g.C + c)] < 0) {
+        throw std::runtime_error("capture: cell not in graph");
+    }
+    return id_of[static_cast<size_t>(r * g.C + c)];
+}
+
+inline DynamicBitset read_cells(std::istream& is, const CellGraph& g, const vector<int>& id_of) {
+    int n = 0;
+    if (!(is >> n)) throw std::runtime_error("capture: truncated cell list");
+    DynamicBitset bits(g.N);
+    for (int j = 0; j < n; j++) bits.set(read_cell(is, g, id_of));
+    return bits;
+}
+
+} // namespace detail
+
+inline void write_capture(std::ostream& os, const vector<string>& grid, int k, const KernelCapture& cap) {
+    CellGraph g = build_cell_graph(grid, cap.order);
+    os << "enclose-capture 2\n";
+    os << "k " << k << "\n";
+    os << "grid " << grid.size() << " " << grid[0].size() << "\n";
+    for (const auto& row : grid) os << row << "\n";
+    os << "flow " << cap.flow_calls.size() << "\n";
+    for (const auto& fc : cap.flow_calls) {
+        os << fc.k_rem << " ";
+        detail::write_cells(os, fc.deleted, g);
+        os << " ";
+        detail::write_cells(os, fc.forced, g);
+        os << "\n";
+    }
+    os << "bfs " << cap.bfs_blocked.size() << "\n";
+    for (const auto& b : cap.bfs_blocked) {
+        detail::write_cells(os, b, g);
+        os << "\n";
+    }
+    os << "reach " << cap.reach_ops.size() << "\n";
+    for (const auto& op : cap.reach_ops) {
+        if (op.kind == KernelCapture::ReachOp::Block) {
+            const auto& rc = g.coords[static_cast<size_t>(op.cell)];
+            os << "b " << rc.first << " " << rc.second;
+        } else if (op.kind == KernelCapture::ReachOp::Undo) {
+            os << "u";
+        } else {
+            os << "a ";
+            detail::write_cells(os, op.walls, g);
+        }
+        os << "\n";
+    }
+}
+
+// Cell sets come back numbered in `order`
+inline CaptureFile read_capture(std::istream& is, CellOrder order = CellOrder::Bfs) {
+    CaptureFile cf;
+    string tag;
+    int version = 0;
+    if (!(is >> tag >> version) || tag != "enclose-capture" || version < 1 || version > 2) {
+        throw std::runtime_error("capture: bad header");
+    }
+    size_t rows = 0, cols = 0;
+    if (!(is >> tag >> cf.k) || tag != "k") throw std::runtime_error("capture: missing k");
+    if (!(is >> tag >> rows >> cols) || tag != "grid") throw std::runtime_error("capture: missing grid");
+    cf.grid.resize(rows);
+    for (auto& row : cf.grid) {
+        if (!(is >> row)) throw std::runtime_error("capture: truncated grid");
+    }
+
+    CellGraph g = build_cell_graph(cf.grid, order);
+    cf.kernels.order = order;
+    vector<int> id_of(static_cast<size_t>(g.R) * static_cast<size_t>(g.C), -1);
+    for (int i = 0; i < g.N; i++) {
+        id_of[static_cast<size_t>(g.coords[static_cast<size_t>(i)].first) * static_cast<size_t>(g.C) +
+              static_cast<size_t>(g.coords[static_cast<size_t>(i)].second)] = i;
+    }
+
+    size_t n = 0;
+    if (!(is >> tag >> n) || tag != "flow") throw std::runtime_error("capture: missing flow section");
+    cf.kernels.flow_calls.resize(n);
+    for (auto& fc : cf.kernels.flow_calls) {
+        if (!(is >> fc.k_rem)) throw std::runtime_error("capture: truncated flow call");
+        fc.deleted = detail::read_cells(is, g, id_of);
+        fc.forced = detail::read_cells(is, g, id_of);
+    }
+    if (!(is >> tag >> n) || tag != "bfs") throw std::runtime_error("capture: missing bfs section");
+    cf.kernels.bfs_blocked.reserve(n);
+    for (size_t j = 0; j < n; j++) cf.kernels.bfs_blocked.push_back(detail::read_cells(is, g, id_of));
+    if (version >= 2) {
+        if (!(is >> tag >> n) || tag != "reach") throw std::runtime_error("capture: missing reach section");
+        cf.kernels.reach_ops.resize(n);
+        for (auto& op : cf.kernels.reach_ops) {
+            if (!(is >> tag)) throw std::runtime_error("capture: truncated reach op");
+            if (tag == "b") {
+                op.kind = KernelCapture::ReachOp::Block;
+                op.cell = detail::read_cell(is, g, id_of);
+            } else if (tag == "u") {
+                op.kind = KernelCapture::ReachOp::Undo;
+            } else if (tag == "a") {
+                op.kind = KernelCapture::ReachOp::Area;
+                op.walls = detail::read_cells(is, g, id_of);
+            } else {
+                throw std::runtime_error("capture: bad reach op");
+            }
+        }
+    }
+    cf.kernels.limit = std::max({cf.kernels.flow_calls.size(), cf.kernels.bfs_blocked.size(),
+                                 cf.kernels.reach_ops.size()});
+    return cf;
+}
+
+} // namespace enclose
@@ -0,0 +1,224 @@
+#pragma once
+
+// corpus.hpp - Binary puzzle corpus: many boards in one memory-mapped file
+//
+// Layout (little-endian, every offset a multiple of 8):
+//   header   "ENCLCRP1" | u32 version (1) | u32 reserved | u64 count | u64 index_offset
+//   records  u32 rows | u32 cols | i32 k | u32 reserved | packed cells
+//   index    u64 record offset x count
+// Cells are PackedGridView words (2 bits per cell, 32 per uint64_t), so a
+// mapped record is handed to the solver without copying or decoding.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ENCLOSE_CORPUS_MMAP 1
+#endif
+
+#include "solver.hpp"
+
+namespace enclose {
+
+namespace detail {
+
+const char kCorpusMagic[8] = {'E', 'N', 'C', 'L', 'C', 'R', 'P', '1'};
+const uint32_t kCorpusVersion = 1;
+
+struct CorpusHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t index_offset;
+};
+
+struct CorpusRecordHeader {
+    uint32_t rows;
+    uint32_t cols;
+    int32_t k;
+    uint32_t reserved;
+};
+
+inline bool host_little_endian() {
+    uint32_t one = 1;
+    unsigned char b;
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+} // namespace detail
+
+/* ---------------- Writer ---------------- */
+
+// Appends boards to a new corpus file; the index and count are written by close()
+class CorpusWriter {
+public:
+    explicit CorpusWriter(const string& path) : out_(path, std::ios::binary | std::ios::trunc) {
+        if (!detail::host_little_endian()) throw std::runtime_error("corpus: big-endian hosts are not supported");
+        if (!out_) throw std::runtime_error("corpus: cannot create " + path);
+        detail::CorpusHeader h{};
+        write(&h, sizeof(h));
+    }
+
+    ~CorpusWriter() {
+        if (!closed_) {
+            try { close(); } catch (...) {}
+        }
+    }
+
+    CorpusWriter(const CorpusWriter&) = delete;
+    CorpusWriter& operator=(const CorpusWriter&) = delete;
+
+    void add(int k, const PackedGridView& grid) {
+        offsets_.push_back(pos_);
+        detail::CorpusRecordHeader rh{static_cast<uint32_t>(grid.R), static_cast<uint32_t>(grid.C), k, 0};
+        write(&rh, sizeof(rh));
+        write(grid.bits, PackedGridView::word_count(grid.R, grid.C) * sizeof(uint64_t));
+    }
+
+    void close() {
+        closed_ = true;
+        detail::CorpusHeader h{};
+        std::memcpy(h.magic, detail::kCorpusMagic, sizeof(h.magic));
+        h.version = detail::kCorpusVersion;
+        h.count = offsets_.size();
+        h.index_offset = pos_;
+        write(offsets_.data(), offsets_.size() * sizeof(uint64_t));
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out_.close();
+        if (!out_) throw std::runtime_error("corpus: write failed");
+    }
+
+    size_t size() const { return offsets_.size(); }
+
+private:
+    std::ofstream out_;
+    uint64_t pos_ = 0;
+    vector<uint64_t> offsets_;
+    bool closed_ = false;
+
+    void write(const void* p, size_t n) {
+        out_.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+        pos_ += n;
+    }
+};
+
+/* ---------------- Reader ---------------- */
+
+struct CorpusBoard {
+    int k = 0;
+    PackedGridView grid;   // points into the mapping
+};
+
+// Read-only view of a corpus file, mapped with mmap where available (read
+// into memory otherwise). Boards stay valid while the Corpus is alive.
+class Corpus {
+public:
+    explicit Corpus(const string& path) {
+        if (!detail::host_little_endian()) throw std::runtime_error("corpus: big-endian hosts are not supported");
+#ifdef ENCLOSE_CORPUS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("corpus: cannot open " + path);
+        struct stat sb;
+        if (fstat(fd, &sb) != 0) {
+            ::close(fd);
+            throw std::runtime_error("corpus: cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(sb.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("corpus: cannot map " + path);
+            }
+            data_ = static_cast<const unsigned char*>(p);
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("corpus: cannot open " + path);
+        in.seekg(0, std::ios::end);
+        size_ = static_cast<size_t>(in.tellg());
+        in.seekg(0);
+        buffer_.resize((size_ + 7) / 8);
+        in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size_));
+        if (!in) throw std::runtime_error("corpus: cannot read " + path);
+        data_ = reinterpret_cast<const unsigned char*>(buffer_.data());
+#endif
+        try {
+            validate();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~Corpus() { release(); }
+
+    Corpus(const Corpus&) = delete;
+    Corpus& operator=(const Corpus&) = delete;
+
+    size_t size() const { return count_; }
+
+    // Board i, checked against the file bounds
+    CorpusBoard at(size_t i) const {
+        if (i >= count_) throw std::runtime_error("corpus: board index out of range");
+        uint64_t off = index_[i];
+        if (off % 8 != 0 || off > size_ || size_ - off < sizeof(detail::CorpusRecordHeader)) {
+            throw std::runtime_error("corpus: bad record offset");
+        }
+        detail::CorpusRecordHeader rh;
+        std::memcpy(&rh, data_ + off, sizeof(rh));
+        if (rh.rows > INT32_MAX || rh.cols > INT32_MAX) throw std::runtime_error("corpus: bad board size");
+        size_t words = PackedGridView::word_count(static_cast<int>(rh.rows), static_cast<int>(rh.cols));
+        if ((size_ - off - sizeof(rh)) / sizeof(uint64_t) < words) throw std::runtime_error("corpus: truncated record");
+        CorpusBoard b;
+        b.k = rh.k;
+        b.grid.R = static_cast<int>(rh.rows);
+        b.grid.C = static_cast<int>(rh.cols);
+        b.grid.bits = reinterpret_cast<const uint64_t*>(data_ + off + sizeof(rh));
+        return b;
+    }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t count_ = 0;
+    const uint64_t* index_ = nullptr;
+#ifndef ENCLOSE_CORPUS_MMAP
+    vector<uint64_t> buffer_;
+#endif
+
+    void validate() {
+        detail::CorpusHeader h;
+        if (size_ < sizeof(h)) throw std::runtime_error("corpus: file too small");
+        std::memcpy(&h, data_, sizeof(h));
+        if (std::memcmp(h.magic, detail::kCorpusMagic, sizeof(h.magic)) != 0) throw std::runtime_error("corpus: bad magic");
+        if (h.version != detail::kCorpusVersion) throw std::runtime_error("corpus: unsupported version");
+        if (h.index_offset % 8 != 0 || h.index_offset > size_ ||
+            (size_ - h.index_offset) / sizeof(uint64_t) < h.count) {
+            throw std::runtime_error("corpus: bad index");
+        }
+        count_ = static_cast<size_t>(h.count);
+        index_ = reinterpret_cast<const uint64_t*>(data_ + h.index_offset);
+    }
+
+    void release() {
+#ifdef ENCLOSE_CORPUS_MMAP
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+        data_ = nullptr;
+    }
+};
+
+} // namespace enclose
@@ -0,0 +1,113 @@
+// corpus_convert.cpp - Convert puzzles between ASCII / JSON Lines and the binary corpus
+// Compile with: clang++ -O2 -std=c++17 -pthread -o corpus_convert corpus_convert.cpp
+//
+//   ./corpus_convert pack boards.bin -k 8 < boards.txt    # blank-line separated grids or JSONL
+//   ./corpus_convert unpack boards.bin > boards.txt       # grids only (k is dropped)
+//   ./corpus_convert unpack boards.bin --jsonl > boards.jsonl
+//   ./corpus_convert info boards.bin
+//
+// Input records without their own k get -k. Unpacking writes every blocked
+// cell as '#'.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "batch.hpp"
+#include "corpus.hpp"
+#include "json.hpp"
+
+using std::string;
+using std::vector;
+
+int pack(const string& path, int k) {
+    enclose::batch::PuzzleReader reader(std::cin, k);
+    enclose::CorpusWriter writer(path);
+    enclose::batch::Puzzle p;
+    size_t skipped = 0;
+    while (reader.next(p)) {
+        if (!p.error.empty() || p.grid.empty()) {
+            std::cerr << "puzzle " << p.index << ": " << (p.error.empty() ? "Empty grid" : p.error) << " (skipped)\n";
+            skipped++;
+            continue;
+        }
+        enclose::PackedGrid pg = enclose::PackedGrid::from_rows(p.grid);
+        writer.add(p.k, pg.view());
+    }
+    size_t n = writer.size();
+    writer.close();
+    std::cerr << "packed " << n << " boards into " << path;
+    if (skipped) std::cerr << " (" << skipped << " skipped)";
+    std::cerr << "\n";
+    return skipped ? 1 : 0;
+}
+
+int unpack(const string& path, bool jsonl) {
+    enclose::Corpus corpus(path);
+    for (size_t i = 0; i < corpus.size(); i++) {
+        enclose::CorpusBoard b = corpus.at(i);
+        vector<string> rows = b.grid.to_rows();
+        if (jsonl) {
+            std::cout << "{\"k\":" << b.k << ",\"grid\":[";
+            for (size_t r = 0; r < rows.size(); r++) {
+                if (r) std::cout << ",";
+                std::cout << enclose::json::quote(rows[r]);
+            }
+            std::cout << "]}\n";
+        } else {
+            if (i) std::cout << "\n";
+            for (const auto& row : rows) std::cout << row << "\n";
+        }
+    }
+    return 0;
+}
+
+int info(const string& path) {
+    enclose::Corpus corpus(path);
+    uint64_t cells = 0;
+    int max_r = 0, max_c = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        enclose::CorpusBoard b = corpus.at(i);
+        cells += static_cast<uint64_t>(b.grid.R) * static_cast<uint64_t>(b.grid.C);
+        max_r = std::max(max_r, b.grid.R);
+        max_c = std::max(max_c, b.grid.C);
+    }
+    std::cout << "boards: " << corpus.size() << "\n"
+              << "cells: " << cells << "\n"
+              << "largest: " << max_r << "x" << max_c << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+    if (argc < 3) {
+        std::cerr << "usage: corpus_convert pack FILE [-k K] < boards\n"
+                     "       corpus_convert unpack FILE [--jsonl]\n"
+                     "       corpus_convert info FILE\n";
+        return 2;
+    }
+    string cmd = argv[1];
+    string path = argv[2];
+    int k = 6;
+    bool jsonl = false;
+    for (int i = 3; i < argc; i++) {
+        string a = argv[i];
+        if ((a == "-k" || a == "--k") && i + 1 < argc) k = std::stoi(argv[++i]);
+        else if (a == "--jsonl") jsonl = true;
+        else {
+            std::cerr << "unknown option: " << a << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        if (cmd == "pack") return pack(path, k);
+        if (cmd == "unpack") return unpack(path, jsonl);
+        if (cmd == "info") return info(path);
+    } catch (const std::exception& e) {
+        std::cerr << "corpus_convert: " << e.what() << "\n";
+        return 1;
+    }
+    std::cerr << "unknown command: " << cmd << " (pack, unpack, info)\n";
+    return 2;
+}
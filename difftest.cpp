@@ -0,0 +1,286 @@
+// difftest.cpp - Randomized differential test against the brute-force oracle
+// Compile with: clang++ -O2 -std=c++17 -pthread -o difftest difftest.cpp
+//
+// Generates small random boards, solves each with the oracle and with every
+// solver variant (engines, option combinations, cache and symmetry paths),
+// and reports any board where a variant's best_area differs or its walls are
+// not a valid answer. New engines and options get a line in make_variants().
+// A few fixed inputs for the request parser (json_checks()) run first.
+//
+//   ./difftest --count 5000 --seed 1
+//   ./difftest --count 200 --max-size 8 --max-k 5 --variants solve,symmetry
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "generator.hpp"
+#include "json.hpp"
+#include "oracle.hpp"
+#include "solver.hpp"
+#include "trace.hpp"
+
+using std::string;
+using std::vector;
+
+/* ---------------- Variants ---------------- */
+
+struct Variant {
+    string name;
+    // Solves (k, grid); walls must be in the grid's own coordinates
+    std::function<enclose::SolveResult(int, const vector<string>&)> run;
+};
+
+// Solve the board under symmetry `sym` and map the walls back
+enclose::SolveResult solve_transformed(int k, const vector<string>& grid, int sym) {
+    int R = static_cast<int>(grid.size());
+    int C = static_cast<int>(grid[0].size());
+    int R2 = (sym & 4) ? C : R;
+    int C2 = (sym & 4) ? R : C;
+    vector<string> t(static_cast<size_t>(R2), string(static_cast<size_t>(C2), '#'));
+    for (int r = 0; r < R; r++) {
+        for (int c = 0; c < C; c++) {
+            auto p = enclose::sym_apply(sym, r, c, R, C);
+            t[static_cast<size_t>(p.first)][static_cast<size_t>(p.second)] = grid[static_cast<size_t>(r)][static_cast<size_t>(c)];
+        }
+    }
+    enclose::SolveResult res = enclose::solve(k, t);
+    for (auto& w : res.walls) w = enclose::sym_invert(sym, w.first, w.second, R, C);
+    return res;
+}
+
+vector<Variant> make_variants() {
+    vector<Variant> v;
+    v.push_back({"solve", [](int k, const vector<string>& g) { return enclose::solve(k, g); }});
+    v.push_back({"stats", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.collect_stats = true;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"raw-memo", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.normalize_memo = false;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"nogoods", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.learn_nogoods = true;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"ek", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.flow_engine = enclose::FlowEngine::EdmondsKarp;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"bk-budget", [](int k, const vector<string>& g) {
+        // Room for a few snapshots only: deeper frames start their children cold
+        enclose::SolveOptions opt;
+        opt.flow_engine = enclose::FlowEngine::BoykovKolmogorov;
+        opt.bk_snapshot_budget = 4096;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"pr", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.flow_engine = enclose::FlowEngine::PushRelabel;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"sink-cut", [](int k, const vector<string>& g) {
+        enclose::SolveOptions opt;
+        opt.branching = enclose::Branching::SinkCut;
+        return enclose::solve(k, g, opt);
+    }});
+    const std::pair<const char*, enclose::CellOrder> orders[] = {
+        {"row-major", enclose::CellOrder::RowMajor},
+        {"morton", enclose::CellOrder::Morton},
+        {"hilbert", enclose::CellOrder::Hilbert},
+    };
+    for (const auto& o : orders) {
+        enclose::CellOrder order = o.second;
+        v.push_back({o.first, [order](int k, const vector<string>& g) {
+            enclose::SolveOptions opt;
+            opt.cell_order = order;
+            return enclose::solve(k, g, opt);
+        }});
+    }
+    v.push_back({"trace", [](int k, const vector<string>& g) {
+        enclose::TraceRecorder trace(1);
+        enclose::SolveOptions opt;
+        opt.trace = &trace;
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"sep-cache", [](int k, const vector<string>& g) {
+        // Warm the cache at a larger and a smaller budget, then solve at k
+        enclose::SeparatorCache cache;
+        enclose::SolveOptions opt;
+        opt.separator_cache = &cache;
+        enclose::solve(k + 2, g, opt);
+        if (k > 1) enclose::solve(k - 1, g, opt);
+        return enclose::solve(k, g, opt);
+    }});
+    v.push_back({"cache-hit", [](int k, const vector<string>& g) {
+        enclose::ResultStore store;
+        enclose::solve_cached(k, g, enclose::SolveOptions(), store);
+        return enclose::solve_cached(k, g, enclose::SolveOptions(), store);
+    }});
+    v.push_back({"symmetry", [](int k, const vector<string>& g) {
+        enclose::SolveResult res = enclose::solve(k, g);
+        for (int sym = 1; sym < 8; sym++) {
+            enclose::SolveResult t = solve_transformed(k, g, sym);
+            if (t.best_area != res.best_area) return t;
+        }
+        return res;
+    }});
+    return v;
+}
+
+/* ---------------- Board generation ---------------- */
+
+struct Case {
+    vector<string> grid;
+    int k = 0;
+};
+
+Case random_case(enclose::gen::Rng& rng, int min_size, int max_size, int max_k) {
+    enclose::gen::Params p;
+    p.rows = min_size + rng.below(max_size - min_size + 1);
+    p.cols = min_size + rng.below(max_size - min_size + 1);
+    p.water = 0.05 + 0.45 * rng.uniform();
+    p.layout = static_cast<enclose::gen::Layout>(rng.below(3));
+    p.corridors = 1 + rng.below(3);
+    p.horse = rng.below(4) == 0 ? enclose::gen::HorsePlacement::Random : enclose::gen::HorsePlacement::Center;
+    p.seed = rng.next();
+    Case c;
+    c.grid = enclose::gen::generate(p);
+    c.k = 1 + rng.below(max_k);
+    return c;
+}
+
+/* ---------------- Parser checks ---------------- */
+
+// Request lines reach json::parse straight off the server socket, so
+// malformed ones must throw, never crash. Returns the number of failures.
+int json_checks() {
+    struct Check {
+        string name;
+        string text;
+        string error;   // expected substring of the message, empty if it must parse
+        string str;     // the string it must decode to, if any
+    };
+    const vector<Check> checks = {
+        {"deep nesting", string(2000000, '['), "json: too deeply nested", ""},
+        {"deep objects", [] {
+             string s;
+             for (int i = 0; i < 1000; i++) s += "{\"a\":";
+             return s;
+         }(), "json: too deeply nested", ""},
+        {"nesting at the limit", string(256, '[') + string(256, ']'), "", ""},
+        {"non-hex escape", "\"\\u12zz\"", "bad unicode escape", ""},
+        {"short escape", "\"\\u12\"", "bad unicode escape", ""},
+        {"hex escape", "\"\\u00e9\\u0041\"", "", "\xc3\xa9" "A"},
+    };
+    int failures = 0;
+    for (const auto& c : checks) {
+        string problem;
+        try {
+            enclose::json::Value v = enclose::json::parse(c.text);
+            if (!c.error.empty()) problem = "parsed, expected \"" + c.error + "\"";
+            else if (!c.str.empty() && v.str != c.str) problem = "decoded as " + v.str;
+        } catch (const std::exception& e) {
+            if (c.error.empty() || string(e.what()).find(c.error) == string::npos) problem = string("threw: ") + e.what();
+        }
+        if (problem.empty()) continue;
+        failures++;
+        std::cout << "FAIL json " << c.name << ": " << problem << "\n";
+    }
+    return failures;
+}
+
+/* ---------------- main ---------------- */
+
+int main(int argc, char** argv) {
+    int count = 1000;
+    int min_size = 4;
+    int max_size = 7;
+    int max_k = 4;
+    uint64_t seed = 1;
+    int max_failures = 1;
+    string only;
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--count" && has) count = std::stoi(argv[++i]);
+        else if (a == "--min-size" && has) min_size = std::max(3, std::stoi(argv[++i]));
+        else if (a == "--max-size" && has) max_size = std::stoi(argv[++i]);
+        else if (a == "--max-k" && has) max_k = std::max(1, std::stoi(argv[++i]));
+        else if (a == "--seed" && has) seed = std::stoull(argv[++i]);
+        else if (a == "--max-failures" && has) max_failures = std::max(1, std::stoi(argv[++i]));
+        else if (a == "--variants" && has) only = "," + string(argv[++i]) + ",";
+        else {
+            std::cerr << "usage: difftest [--count N] [--seed S] [--min-size N] [--max-size N] [--max-k K]\n"
+                         "                [--variants a,b,...] [--max-failures N]\n";
+            return 2;
+        }
+    }
+    max_size = std::max(max_size, min_size);
+
+    vector<Variant> variants;
+    for (auto& v : make_variants()) {
+        if (only.empty() || only.find("," + v.name + ",") != string::npos) variants.push_back(std::move(v));
+    }
+    if (variants.empty()) {
+        std::cerr << "no variants selected\n";
+        return 2;
+    }
+
+    int json_failures = json_checks();
+
+    enclose::gen::Rng rng(seed);
+    int failures = json_failures, skipped = 0, checked = 0, enclosed = 0;
+    for (int n = 0; n < count && failures < max_failures; n++) {
+        Case c = random_case(rng, min_size, max_size, max_k);
+        enclose::SolveResult expect;
+        try {
+            expect = enclose::oracle::solve_brute_force(c.k, c.grid);
+        } catch (const std::exception&) {
+            skipped++;
+            continue;
+        }
+        checked++;
+        if (expect.best_area > 0) enclosed++;
+        for (const auto& v : variants) {
+            string problem;
+            enclose::SolveResult got;
+            try {
+                got = v.run(c.k, c.grid);
+                if (got.best_area != expect.best_area) {
+                    problem = "area " + std::to_string(got.best_area) + ", oracle " + std::to_string(expect.best_area);
+                } else {
+                    problem = enclose::oracle::check_walls(c.k, c.grid, got);
+                }
+            } catch (const std::exception& e) {
+                problem = string("threw: ") + e.what();
+            }
+            if (problem.empty()) continue;
+
+            failures++;
+            std::cout << "FAIL case " << n << " variant " << v.name << " k=" << c.k << ": " << problem << "\n";
+            for (const auto& row : c.grid) std::cout << "  " << row << "\n";
+            std::cout << "  oracle walls:";
+            for (const auto& w : expect.walls) std::cout << " (" << w.first << ", " << w.second << ")";
+            std::cout << "\n  variant walls:";
+            for (const auto& w : got.walls) std::cout << " (" << w.first << ", " << w.second << ")";
+            std::cout << "\n";
+            if (failures >= max_failures) break;
+        }
+    }
+
+    std::cerr << "difftest: " << checked << " boards (" << enclosed << " enclosable) x " << variants.size() << " variants, "
+              << failures - json_failures << " failures, " << skipped << " skipped (too large for the oracle)";
+    if (json_failures) std::cerr << ", " << json_failures << " parser failures";
+    std::cerr << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+// gen.cpp - Random puzzle generator (ASCII boards in the format solve2 reads)
+// Compile with: clang++ -O2 -std=c++17 -o gen gen.cpp
+//
+// Examples:
+//   ./gen --size 40 --water 0.25 --layout clustered --seed 7 > board.txt
+//   ./gen --size 30 --count 100 --jsonl --k 8 | ./solve2 --batch
+//   ./gen --size 24 --k 10 --target-nodes 20000 --attempts 20 > hard.txt
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "generator.hpp"
+#include "json.hpp"
+#include "solver.hpp"
+
+using std::string;
+using std::vector;
+
+/* ---------------- Hardness targeting ---------------- */
+
+// Search nodes needed to solve the board at k (capped by a deadline)
+uint64_t board_hardness(const vector<string>& grid, int k, double timeout_ms) {
+    enclose::SolveOptions opt;
+    opt.collect_stats = true;
+    opt.deadline = enclose::SolveOptions::clock::now() +
+                   std::chrono::duration_cast<enclose::SolveOptions::clock::duration>(
+                       std::chrono::duration<double, std::milli>(timeout_ms));
+    return enclose::solve(k, grid, opt).stats.nodes;
+}
+
+// Generate `attempts` candidates from consecutive seeds and keep the one whose
+// node count is closest to the target on a log scale
+vector<string> generate_targeted(enclose::gen::Params p, int k, uint64_t target_nodes,
+                                 int attempts, double timeout_ms, uint64_t& nodes_out) {
+    vector<string> best;
+    double best_dist = 0.0;
+    uint64_t base_seed = p.seed;
+    for (int a = 0; a < attempts; a++) {
+        p.seed = base_seed * 1000003ULL + static_cast<uint64_t>(a);
+        vector<string> g = enclose::gen::generate(p);
+        uint64_t nodes = board_hardness(g, k, timeout_ms);
+        double dist = std::fabs(std::log(static_cast<double>(nodes) + 1.0) -
+                                std::log(static_cast<double>(target_nodes) + 1.0));
+        if (best.empty() || dist < best_dist) {
+            best = g;
+            best_dist = dist;
+            nodes_out = nodes;
+        }
+    }
+    return best;
+}
+
+/* ---------------- main ---------------- */
+
+int main(int argc, char** argv) {
+    enclose::gen::Params p;
+    int count = 1;
+    bool jsonl = false;
+    int k = 6;
+    uint64_t target_nodes = 0;
+    int attempts = 10;
+    double timeout_ms = 10000.0;
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--rows" && has) p.rows = std::stoi(argv[++i]);
+        else if (a == "--cols" && has) p.cols = std::stoi(argv[++i]);
+        else if (a == "--size" && has) p.rows = p.cols = std::stoi(argv[++i]);
+        else if (a == "--water" && has) p.water = std::stod(argv[++i]);
+        else if (a == "--cluster" && has) p.cluster = std::stod(argv[++i]);
+        else if (a == "--corridors" && has) p.corridors = std::stoi(argv[++i]);
+        else if (a == "--seed" && has) p.seed = std::stoull(argv[++i]);
+        else if (a == "--count" && has) count = std::stoi(argv[++i]);
+        else if (a == "--k" && has) k = std::stoi(argv[++i]);
+        else if (a == "--target-nodes" && has) target_nodes = std::stoull(argv[++i]);
+        else if (a == "--attempts" && has) attempts = std::stoi(argv[++i]);
+        else if (a == "--timeout-ms" && has) timeout_ms = std::stod(argv[++i]);
+        else if (a == "--jsonl") jsonl = true;
+        else if (a == "--layout" && has) {
+            string l = argv[++i];
+            if (!enclose::gen::parse_layout(l, p.layout)) {
+                std::cerr << "unknown --layout: " << l << " (uniform, clustered, corridors)\n";
+                return 2;
+            }
+        } else if (a == "--horse" && has) {
+            string h = argv[++i];
+            if (h == "center") p.horse = enclose::gen::HorsePlacement::Center;
+            else if (h == "random") p.horse = enclose::gen::HorsePlacement::Random;
+            else {
+                std::cerr << "unknown --horse: " << h << " (center, random)\n";
+                return 2;
+            }
+        } else {
+            std::cerr << "usage: gen [--size N | --rows R --cols C] [--water F] [--layout uniform|clustered|corridors]\n"
+                         "           [--cluster P] [--corridors N] [--horse center|random] [--seed S] [--count N]\n"
+                         "           [--jsonl] [--k K] [--target-nodes N [--attempts A] [--timeout-ms T]]\n";
+            return 2;
+        }
+    }
+
+    try {
+        uint64_t seed0 = p.seed;
+        for (int n = 0; n < count; n++) {
+            p.seed = seed0 + static_cast<uint64_t>(n);
+            vector<string> g;
+            if (target_nodes > 0) {
+                uint64_t nodes = 0;
+                g = generate_targeted(p, k, target_nodes, attempts, timeout_ms, nodes);
+                std::cerr << "seed " << p.seed << ": " << nodes << " nodes at k=" << k << "\n";
+            } else {
+                g = enclose::gen::generate(p);
+            }
+
+            if (jsonl) {
+                string text;
+                for (const auto& row : g) text += row + "\n";
+                std::cout << "{\"id\":\"gen-" << p.rows << "x" << p.cols << "-" << p.seed << "\",\"grid\":"
+                          << enclose::json::quote(text) << ",\"k\":" << k << "}\n";
+            } else {
+                if (n) std::cout << "\n";
+                for (const auto& row : g) std::cout << row << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "gen: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// generator.hpp - Seeded random board generator for scaling and stress tests
+// Boards use the solver's ASCII alphabet ('.', '#', 'H'). The generator has its
+// own RNG so a (params, seed) pair yields the same board on every platform.
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "solver.hpp"
+
+namespace enclose {
+namespace gen {
+
+using std::string;
+using std::vector;
+
+/* ---------------- Rng ---------------- */
+
+struct Rng {
+    uint64_t state;
+
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state += 0x9e3779b97f4a7c15ULL;
+        return splitmix64(state);
+    }
+    // Uniform integer in [0, n)
+    int below(int n) {
+        return static_cast<int>(next() % static_cast<uint64_t>(n));
+    }
+    // Uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+/* ---------------- Parameters ---------------- */
+
+enum class Layout {
+    Uniform,     // water cells scattered independently
+    Clustered,   // water grows into lakes
+    Corridors,   // long water lines with gaps, rest scattered
+};
+
+enum class HorsePlacement { Center, Random };
+
+struct Params {
+    int rows = 16;
+    int cols = 16;
+    double water = 0.2;          // fraction of cells that are water
+    Layout layout = Layout::Uniform;
+    double cluster = 0.75;       // Clustered: probability a water cell extends an existing lake
+    int corridors = 4;           // Corridors: number of water lines
+    HorsePlacement horse = HorsePlacement::Center;
+    uint64_t seed = 1;
+};
+
+inline bool parse_layout(const string& s, Layout& out) {
+    if (s == "uniform") out = Layout::Uniform;
+    else if (s == "clustered") out = Layout::Clustered;
+    else if (s == "corridors") out = Layout::Corridors;
+    else return false;
+    return true;
+}
+
+/* ---------------- Generation ---------------- */
+
+inline vector<string> generate(const Params& p) {
+    if (p.rows < 3 || p.cols < 3) throw std::runtime_error("board must be at least 3x3");
+    const int R = p.rows, C = p.cols;
+    Rng rng(splitmix64(p.seed) ^ (static_cast<uint64_t>(R) << 32) ^ static_cast<uint64_t>(C));
+
+    vector<string> g(static_cast<size_t>(R), string(static_cast<size_t>(C), '.'));
+    long long target = static_cast<long long>(p.water * R * C);
+    target = std::max(0LL, std::min(target, static_cast<long long>(R) * C - 1));
+    long long placed = 0;
+    vector<int> water_cells;
+    water_cells.reserve(static_cast<size_t>(target));
+
+    auto put = [&](int r, int c) {
+        char& ch = g[static_cast<size_t>(r)][static_cast<size_t>(c)];
+        if (ch == '#') return;
+        ch = '#';
+        water_cells.push_back(r * C + c);
+        placed++;
+    };
+
+    if (p.layout == Layout::Corridors) {
+        for (int i = 0; i < p.corridors && placed < target; i++) {
+            bool horizontal = (i % 2) == 0;
+            int len = horizontal ? C : R;
+            int line = 1 + rng.below(horizontal ? R - 2 : C - 2);
+            int gaps = 1 + rng.below(3);
+            vector<int> gap_at;
+            for (int j = 0; j < gaps; j++) gap_at.push_back(rng.below(len));
+            for (int t = 0; t < len && placed < target; t++) {
+                if (std::find(gap_at.begin(), gap_at.end(), t) != gap_at.end()) continue;
+                if (horizontal) put(line, t);
+                else put(t, line);
+            }
+        }
+    }
+
+    const int drs[4] = {1, -1, 0, 0};
+    const int dcs[4] = {0, 0, 1, -1};
+    while (placed < target) {
+        if (p.layout == Layout::Clustered && !water_cells.empty() && rng.uniform() < p.cluster) {
+            int cell = water_cells[static_cast<size_t>(rng.below(static_cast<int>(water_cells.size())))];
+            int d = rng.below(4);
+            int r = cell / C + drs[d], c = cell % C + dcs[d];
+            if (r >= 0 && r < R && c >= 0 && c < C) put(r, c);
+        } else {
+            put(rng.below(R), rng.below(C));
+        }
+    }
+
+    int hr = R / 2, hc = C / 2;
+    if (p.horse == HorsePlacement::Random) {
+        hr = 1 + rng.below(R - 2);
+        hc = 1 + rng.below(C - 2);
+    }
+    g[static_cast<size_t>(hr)][static_cast<size_t>(hc)] = 'H';
+    return g;
+}
+
+} // namespace gen
+} // namespace enclose
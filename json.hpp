@@ -0,0 +1,311 @@
+#pragma once
+
+// json.hpp - Minimal JSON reader/writer helpers for the CLI front ends
+// Only what the line-oriented protocols need: objects, arrays, strings,
+// numbers, booleans and null. Not a general purpose JSON library.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace enclose {
+namespace json {
+
+using std::map;
+using std::string;
+using std::vector;
+
+/* ---------------- Value ---------------- */
+
+struct Value {
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Null;
+    bool b = false;
+    double num = 0.0;
+    string str;
+    vector<Value> arr;
+    map<string, Value> obj;
+
+    bool is_null() const { return type == Null; }
+    bool is_number() const { return type == Number; }
+    bool is_string() const { return type == String; }
+    bool is_array() const { return type == Array; }
+    bool is_object() const { return type == Object; }
+
+    const Value* find(const string& key) const {
+        if (type != Object) return nullptr;
+        auto it = obj.find(key);
+        return it == obj.end() ? nullptr : &it->second;
+    }
+};
+
+/* ---------------- Parser ---------------- */
+
+class Parser {
+public:
+    explicit Parser(const string& text) : s_(text) {}
+
+    Value parse() {
+        Value v = parse_value();
+        skip_ws();
+        if (pos_ != s_.size()) fail("trailing characters");
+        return v;
+    }
+
+private:
+    // Arrays and objects nest no deeper; parse_value recurses once per level
+    static constexpr int MAX_DEPTH = 256;
+
+    const string& s_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+
+    [[noreturn]] void fail(const char* what) const {
+        std::ostringstream os;
+        os << "json: " << what << " at offset " << pos_;
+        throw std::runtime_error(os.str());
+    }
+
+    void skip_ws() {
+        while (pos_ < s_.size() &&
+               (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\n' || s_[pos_] == '\r')) {
+            pos_++;
+        }
+    }
+
+    bool consume(char ch) {
+        skip_ws();
+        if (pos_ < s_.size() && s_[pos_] == ch) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char ch) {
+        if (!consume(ch)) fail("unexpected character");
+    }
+
+    bool match_word(const char* w) {
+        size_t n = 0;
+        while (w[n]) n++;
+        if (s_.compare(pos_, n, w) != 0) return false;
+        pos_ += n;
+        return true;
+    }
+
+    Value parse_value() {
+        skip_ws();
+        if (pos_ >= s_.size()) fail("unexpected end of input");
+        char ch = s_[pos_];
+        Value v;
+        if (ch == '{' || ch == '[') {
+            if (++depth_ > MAX_DEPTH) fail("too deeply nested");
+            v = ch == '{' ? parse_object() : parse_array();
+            depth_--;
+        } else if (ch == '"') {
+            v.type = Value::String;
+            v.str = parse_string();
+        } else if (match_word("true")) {
+            v.type = Value::Bool;
+            v.b = true;
+        } else if (match_word("false")) {
+            v.type = Value::Bool;
+        } else if (match_word("null")) {
+            v.type = Value::Null;
+        } else {
+            v.num = parse_number();
+            v.type = Value::Number;
+        }
+        return v;
+    }
+
+    Value parse_object() {
+        pos_++;
+        Value v;
+        v.type = Value::Object;
+        if (consume('}')) return v;
+        do {
+            skip_ws();
+            if (pos_ >= s_.size() || s_[pos_] != '"') fail("expected key");
+            string key = parse_string();
+            expect(':');
+            v.obj[key] = parse_value();
+        } while (consume(','));
+        expect('}');
+        return v;
+    }
+
+    Value parse_array() {
+        pos_++;
+        Value v;
+        v.type = Value::Array;
+        if (consume(']')) return v;
+        do {
+            v.arr.push_back(parse_value());
+        } while (consume(','));
+        expect(']');
+        return v;
+    }
+
+    bool digits() {
+        size_t start = pos_;
+        while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9') pos_++;
+        return pos_ > start;
+    }
+
+    // JSON number grammar only; strtod alone would also take nan, inf, hex
+    double parse_number() {
+        size_t start = pos_;
+        if (pos_ < s_.size() && s_[pos_] == '-') pos_++;
+        if (pos_ < s_.size() && s_[pos_] == '0') pos_++;
+        else if (!digits()) fail("invalid value");
+        if (pos_ < s_.size() && s_[pos_] == '.') {
+            pos_++;
+            if (!digits()) fail("invalid number");
+        }
+        if (pos_ < s_.size() && (s_[pos_] == 'e' || s_[pos_] == 'E')) {
+            pos_++;
+            if (pos_ < s_.size() && (s_[pos_] == '+' || s_[pos_] == '-')) pos_++;
+            if (!digits()) fail("invalid number");
+        }
+        return std::strtod(s_.substr(start, pos_ - start).c_str(), nullptr);
+    }
+
+    static void put_utf8(string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    string parse_string() {
+        pos_++; // opening quote
+        string out;
+        while (true) {
+            if (pos_ >= s_.size()) fail("unterminated string");
+            char ch = s_[pos_++];
+            if (ch == '"') break;
+            if (ch != '\\') {
+                out += ch;
+                continue;
+            }
+            if (pos_ >= s_.size()) fail("unterminated escape");
+            char e = s_[pos_++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (pos_ + 4 > s_.size()) fail("bad unicode escape");
+                    uint32_t cp = 0;
+                    for (int i = 0; i < 4; i++, pos_++) {
+                        char h = s_[pos_];
+                        int d = h >= '0' && h <= '9' ? h - '0'
+                              : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                              : h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+                        if (d < 0) fail("bad unicode escape");
+                        cp = cp * 16 + static_cast<uint32_t>(d);
+                    }
+                    put_utf8(out, cp);
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        return out;
+    }
+};
+
+inline Value parse(const string& text) {
+    return Parser(text).parse();
+}
+
+// v as an int if it is a finite whole number within [lo, hi]
+inline bool get_int(const Value& v, int lo, int hi, int& out) {
+    if (!v.is_number() || !std::isfinite(v.num) || v.num != std::floor(v.num)) return false;
+    if (v.num < static_cast<double>(lo) || v.num > static_cast<double>(hi)) return false;
+    out = static_cast<int>(v.num);
+    return true;
+}
+
+/* ---------------- Writer helpers ---------------- */
+
+inline string escape(const string& s) {
+    string out;
+    out.reserve(s.size() + 8);
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"') out += "\\\"";
+        else if (c == '\\') out += "\\\\";
+        else if (u < 0x20) {
+            // every control byte, so a response never spans two lines
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[u >> 4];
+            out += hex[u & 15];
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+inline string quote(const string& s) {
+    return "\"" + escape(s) + "\"";
+}
+
+// Serialize a value back to compact JSON (used to echo request ids)
+inline void write(std::ostream& os, const Value& v) {
+    switch (v.type) {
+        case Value::Null: os << "null"; break;
+        case Value::Bool: os << (v.b ? "true" : "false"); break;
+        case Value::Number: {
+            // 1e400 parses to inf, which JSON cannot spell
+            if (!std::isfinite(v.num)) os << "null";
+            else if (v.num == std::floor(v.num) && std::fabs(v.num) < 9.0e18) os << static_cast<long long>(v.num);
+            else os << v.num;
+            break;
+        }
+        case Value::String: os << quote(v.str); break;
+        case Value::Array: {
+            os << "[";
+            for (size_t i = 0; i < v.arr.size(); i++) {
+                if (i) os << ",";
+                write(os, v.arr[i]);
+            }
+            os << "]";
+            break;
+        }
+        case Value::Object: {
+            os << "{";
+            bool first = true;
+            for (const auto& kv : v.obj) {
+                if (!first) os << ",";
+                first = false;
+                os << quote(kv.first) << ":";
+                write(os, kv.second);
+            }
+            os << "}";
+            break;
+        }
+    }
+}
+
+} // namespace json
+} // namespace enclose
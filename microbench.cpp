@@ -0,0 +1,310 @@
+// microbench.cpp - Microbenchmarks for the hot kernels in solver.hpp
+// Compile with: clang++ -O2 -std=c++17 -o microbench microbench.cpp
+//
+// Times DynamicBitset operations at several widths, and replays real inputs
+// captured from a solve through FlowTemplate::maxflow_limit and the
+// reachability BFS, so a kernel change can be judged without the noise of the
+// whole search.
+//
+//   ./microbench                        # bitsets + kernels captured from a generated board
+//   ./microbench --board b.txt -k 8     # capture from a board on the fly
+//   ./microbench --capture cap.txt      # replay a file written by solve2 --capture
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "capture.hpp"
+#include "generator.hpp"
+#include "solver.hpp"
+
+using std::string;
+using std::vector;
+
+/* ---------------- Timing ---------------- */
+
+static volatile uint64_t g_sink = 0;
+
+struct Timing {
+    string name;
+    string shape;      // width or input count
+    double median_ns = 0.0;
+    double min_ns = 0.0;
+};
+
+// Run fn (which performs `ops` operations) `reps` times; report ns per operation
+Timing measure(const string& name, const string& shape, size_t ops, int reps, const std::function<void()>& fn) {
+    using clock = std::chrono::steady_clock;
+    fn();   // warmup
+    vector<double> per_op;
+    for (int r = 0; r < reps; r++) {
+        auto t0 = clock::now();
+        fn();
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+        per_op.push_back(ns / static_cast<double>(ops == 0 ? 1 : ops));
+    }
+    std::sort(per_op.begin(), per_op.end());
+    Timing t;
+    t.name = name;
+    t.shape = shape;
+    t.median_ns = per_op[per_op.size() / 2];
+    t.min_ns = per_op.front();
+    return t;
+}
+
+/* ---------------- DynamicBitset ---------------- */
+
+enclose::DynamicBitset random_bits(int n, double density, enclose::gen::Rng& rng) {
+    enclose::DynamicBitset b(n);
+    for (int i = 0; i < n; i++) {
+        if (rng.uniform() < density) b.set(i);
+    }
+    return b;
+}
+
+void bench_bitsets(int reps, vector<Timing>& out) {
+    const int widths[] = {64, 256, 1024, 4096, 16384, 65536};
+    enclose::gen::Rng rng(42);
+    for (int n : widths) {
+        string shape = std::to_string(n) + " bits";
+        size_t iters = std::max<size_t>(16, (size_t(1) << 22) / static_cast<size_t>(n));
+        enclose::DynamicBitset a = random_bits(n, 0.05, rng);
+        enclose::DynamicBitset b = random_bits(n, 0.05, rng);
+        enclose::DynamicBitset disjoint(n);
+        enclose::DynamicBitset full(n);
+        for (int i = 0; i < n; i++) full.set(i);
+        vector<int> probes(1024);
+        for (auto& p : probes) p = rng.below(n);
+
+        out.push_back(measure("bitset.copy", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) {
+                enclose::DynamicBitset c = a;
+                g_sink += c.w[0];
+            }
+        }));
+        out.push_back(measure("bitset.or_with", shape, iters, reps, [&] {
+            enclose::DynamicBitset c = a;
+            for (size_t i = 0; i < iters; i++) c.or_with(b);
+            g_sink += c.w[0];
+        }));
+        out.push_back(measure("bitset.operator|", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) g_sink += (a | b).w[0];
+        }));
+        out.push_back(measure("bitset.intersects", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) g_sink += a.intersects(disjoint);
+        }));
+        out.push_back(measure("bitset.subset_of", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) g_sink += a.subset_of(full);
+        }));
+        out.push_back(measure("bitset.popcount", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) g_sink += static_cast<uint64_t>(a.popcount());
+        }));
+        out.push_back(measure("bitset.for_each_set_bit", shape, iters, reps, [&] {
+            for (size_t i = 0; i < iters; i++) a.for_each_set_bit([&](int x) { g_sink += static_cast<uint64_t>(x); });
+        }));
+        out.push_back(measure("bitset.hash", shape, iters, reps, [&] {
+            enclose::BitsetHash h;
+            for (size_t i = 0; i < iters; i++) g_sink += h(a);
+        }));
+        out.push_back(measure("bitset.test", shape, iters * probes.size(), reps, [&] {
+            for (size_t i = 0; i < iters; i++) {
+                for (int p : probes) g_sink += a.test(p);
+            }
+        }));
+    }
+}
+
+/* ---------------- Kernel replay ---------------- */
+
+// init_caps, cap copy, maxflow_limit, PushRelabel and cold BkFlow runs on the captured states, with capacities of type Cap
+template <class Cap>
+void bench_flow(const enclose::CaptureFile& cf, const enclose::CellGraph& g, const string& suffix,
+                int reps, vector<Timing>& out) {
+    enclose::SeparatorNetwork<Cap> net(g, cf.k);
+    const auto& calls = cf.kernels.flow_calls;
+
+    vector<vector<Cap>> caps(calls.size());
+    for (size_t i = 0; i < calls.size(); i++) net.init_caps(calls[i].deleted, calls[i].forced, caps[i]);
+
+    string shape = std::to_string(calls.size()) + " calls, " + std::to_string(g.N) + " cells";
+    out.push_back(measure("network.init_caps" + suffix, shape, calls.size(), reps, [&] {
+        vector<Cap> cap;
+        for (const auto& fc : calls) {
+            net.init_caps(fc.deleted, fc.forced, cap);
+            g_sink += static_cast<uint64_t>(cap[0]);
+        }
+    }));
+    out.push_back(measure("flow.cap_copy" + suffix, shape, calls.size(), reps, [&] {
+        vector<Cap> cap;
+        for (const auto& c : caps) {
+            cap = c;
+            g_sink += static_cast<uint64_t>(cap[0]);
+        }
+    }));
+    out.push_back(measure("flow.maxflow_limit" + suffix, shape, calls.size(), reps, [&] {
+        vector<Cap> cap;
+        for (size_t i = 0; i < calls.size(); i++) {
+            cap = caps[i];
+            g_sink += static_cast<uint64_t>(net.flow.maxflow_limit(net.SRC, net.SNK, cap, calls[i].k_rem + 1));
+        }
+    }));
+    out.push_back(measure("flow.push_relabel" + suffix, shape, calls.size(), reps, [&] {
+        enclose::PushRelabel<Cap> pr(net.flow);
+        vector<Cap> cap;
+        for (size_t i = 0; i < calls.size(); i++) {
+            cap = caps[i];
+            g_sink += static_cast<uint64_t>(pr.maxflow_limit(net.SRC, net.SNK, cap, calls[i].k_rem + 1));
+        }
+    }));
+    // cold BK runs (no resumed trees); the cut sides come with the result
+    out.push_back(measure("flow.bk_run" + suffix, shape, calls.size(), reps, [&] {
+        enclose::BkFlow<Cap> bk(net.flow, net.SRC, net.SNK);
+        vector<Cap> cap;
+        for (size_t i = 0; i < calls.size(); i++) {
+            cap = caps[i];
+            bk.start(cap);
+            g_sink += static_cast<uint64_t>(bk.run(calls[i].k_rem + 1));
+        }
+    }));
+}
+
+void bench_kernels(const enclose::CaptureFile& cf, int reps, vector<Timing>& out) {
+    enclose::CellGraph g = enclose::build_cell_graph(cf.grid, cf.kernels.order);
+    const auto& blocked = cf.kernels.bfs_blocked;
+
+    bench_flow<int>(cf, g, "<int>", reps, out);
+    if (cf.k < INT8_MAX) bench_flow<int8_t>(cf, g, "<int8_t>", reps, out);
+
+    string bfs_shape = std::to_string(blocked.size()) + " calls, " + std::to_string(g.N) + " cells";
+    out.push_back(measure("graph.reachable", bfs_shape, blocked.size(), reps, [&] {
+        enclose::DynamicBitset vis;
+        int area = 0;
+        bool esc = false;
+        for (const auto& b : blocked) {
+            g.reachable(b, vis, area, esc);
+            g_sink += static_cast<uint64_t>(area);
+        }
+    }));
+
+    // The solver's reachability path: ReachTracker calls in search order.
+    // Each rep starts from a reset (one BFS), as the solve does. Version 1
+    // captures have none.
+    const auto& ops = cf.kernels.reach_ops;
+    if (ops.empty()) return;
+    size_t areas = 0;
+    for (const auto& op : ops) areas += op.kind == enclose::KernelCapture::ReachOp::Area;
+    string reach_shape = std::to_string(ops.size()) + " ops, " + std::to_string(areas) + " areas";
+    auto replay = [&](bool with_areas) {
+        enclose::ReachTracker tr(g);
+        tr.reset(enclose::DynamicBitset(g.N));
+        for (const auto& op : ops) {
+            if (op.kind == enclose::KernelCapture::ReachOp::Block) tr.block(op.cell);
+            else if (op.kind == enclose::KernelCapture::ReachOp::Undo) tr.undo();
+            else if (with_areas) g_sink += static_cast<uint64_t>(tr.area_without(op.walls));
+        }
+        g_sink += static_cast<uint64_t>(tr.area());
+    };
+    out.push_back(measure("reach.replay", reach_shape, ops.size(), reps, [&] { replay(true); }));
+    out.push_back(measure("reach.block_undo", reach_shape, ops.size() - areas, reps, [&] { replay(false); }));
+}
+
+enclose::CaptureFile capture_from_board(const vector<string>& grid, int k, size_t limit, enclose::CellOrder order) {
+    enclose::CaptureFile cf;
+    cf.grid = grid;
+    cf.k = k;
+    cf.kernels.limit = limit;
+    enclose::SolveOptions opt;
+    opt.capture = &cf.kernels;
+    opt.cell_order = order;
+    enclose::solve(k, grid, opt);
+    return cf;
+}
+
+/* ---------------- main ---------------- */
+
+int main(int argc, char** argv) {
+    string capture_path;
+    string board_path;
+    int k = 8;
+    int reps = 7;
+    size_t limit = 4096;
+    bool csv = false;
+    bool bitsets = true;
+    bool kernels = true;
+    enclose::CellOrder order = enclose::CellOrder::Bfs;
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has = i + 1 < argc;
+        if (a == "--capture" && has) capture_path = argv[++i];
+        else if (a == "--board" && has) board_path = argv[++i];
+        else if ((a == "-k" || a == "--k") && has) k = std::stoi(argv[++i]);
+        else if (a == "--reps" && has) reps = std::max(1, std::stoi(argv[++i]));
+        else if (a == "--limit" && has) limit = static_cast<size_t>(std::stoul(argv[++i]));
+        else if (a == "--cell-order" && has && enclose::parse_cell_order(argv[i + 1], order)) i++;
+        else if (a == "--csv") csv = true;
+        else if (a == "--bitsets-only") kernels = false;
+        else if (a == "--kernels-only") bitsets = false;
+        else {
+            std::cerr << "usage: microbench [--capture FILE | --board FILE -k K] [--reps N] [--limit N]\n"
+                         "                  [--bitsets-only | --kernels-only] [--cell-order bfs|row-major|morton|hilbert] [--csv]\n";
+            return 2;
+        }
+    }
+
+    vector<Timing> results;
+    try {
+        if (bitsets) bench_bitsets(reps, results);
+        if (kernels) {
+            enclose::CaptureFile cf;
+            if (!capture_path.empty()) {
+                std::ifstream in(capture_path);
+                if (!in) throw std::runtime_error("cannot open " + capture_path);
+                cf = enclose::read_capture(in, order);
+            } else if (!board_path.empty()) {
+                std::ifstream in(board_path);
+                if (!in) throw std::runtime_error("cannot open " + board_path);
+                vector<string> grid;
+                string line;
+                while (std::getline(in, line)) {
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    if (!line.empty()) grid.push_back(line);
+                }
+                cf = capture_from_board(grid, k, limit, order);
+            } else {
+                enclose::gen::Params p;
+                p.rows = p.cols = 40;
+                p.water = 0.3;
+                p.layout = enclose::gen::Layout::Clustered;
+                cf = capture_from_board(enclose::gen::generate(p), k, limit, order);
+            }
+            bench_kernels(cf, reps, results);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "microbench: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (csv) {
+        std::cout << "kernel,shape,median_ns,min_ns\n";
+        for (const auto& t : results) {
+            std::cout << t.name << "," << t.shape << "," << t.median_ns << "," << t.min_ns << "\n";
+        }
+    } else {
+        std::cout << std::fixed << std::setprecision(1);
+        for (const auto& t : results) {
+            std::cout << t.name;
+            for (size_t pad = t.name.size(); pad < 28; pad++) std::cout << ' ';
+            std::cout << t.shape;
+            for (size_t pad = t.shape.size(); pad < 28; pad++) std::cout << ' ';
+            std::cout << t.median_ns << " ns/op (min " << t.min_ns << ")\n";
+        }
+    }
+    return 0;
+}
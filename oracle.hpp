@@ -0,0 +1,136 @@
+#pragma once
+
+// oracle.hpp - Brute-force reference solver and result checker
+// Enumerates every set of at most k walls, so it is only usable on small
+// boards, but it shares nothing with the separator search beyond the cell
+// graph and is the ground truth difftest compares the real engines against.
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "solver.hpp"
+
+namespace enclose {
+namespace oracle {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+/* ---------------- Reference solver ---------------- */
+
+// Best area over all wall sets of size <= k; throws once more than
+// max_subsets sets would have to be tried. Walls are sorted (row, col).
+inline SolveResult solve_brute_force(int k, const vector<string>& grid, uint64_t max_subsets = 2000000) {
+    CellGraph g = build_cell_graph(grid);
+    vector<int> cand;
+    for (int i = 0; i < g.N; i++) {
+        if (g.wallable[static_cast<size_t>(i)]) cand.push_back(i);
+    }
+    const int m = static_cast<int>(cand.size());
+    k = std::max(0, std::min(k, m));
+
+    SolveResult best;
+    DynamicBitset blocked(g.N), vis;
+    vector<int> chosen, best_walls;
+    uint64_t tried = 0;
+
+    auto evaluate = [&]() {
+        if (++tried > max_subsets) throw std::runtime_error("oracle: board too large for brute force");
+        int area = 0;
+        bool escapes = true;
+        g.reachable(blocked, vis, area, escapes);
+        if (!escapes && area > best.best_area) {
+            best.best_area = area;
+            best_walls = chosen;
+        }
+    };
+
+    // Subsets in order of size, each as an increasing index sequence into cand
+    std::function<void(int, int)> rec = [&](int start, int left) {
+        if (left == 0) {
+            evaluate();
+            return;
+        }
+        for (int j = start; j <= m - left; j++) {
+            blocked.set(cand[static_cast<size_t>(j)]);
+            chosen.push_back(cand[static_cast<size_t>(j)]);
+            rec(j + 1, left - 1);
+            chosen.pop_back();
+            blocked.reset(cand[static_cast<size_t>(j)]);
+        }
+    };
+    for (int size = 0; size <= k; size++) rec(0, size);
+
+    for (int i : best_walls) best.walls.push_back(g.coords[static_cast<size_t>(i)]);
+    std::sort(best.walls.begin(), best.walls.end());
+    return best;
+}
+
+/* ---------------- Result checker ---------------- */
+
+// Checks that `res` is a feasible answer for (grid, k): at most k distinct
+// walls, all on '.' cells, and placing them encloses exactly best_area cells
+// around the horse. Returns an empty string when valid, else the reason.
+inline string check_walls(int k, const vector<string>& grid, const SolveResult& res) {
+    const int R = static_cast<int>(grid.size());
+    const int C = R ? static_cast<int>(grid[0].size()) : 0;
+    if (static_cast<int>(res.walls.size()) > k) {
+        return std::to_string(res.walls.size()) + " walls exceed k=" + std::to_string(k);
+    }
+    vector<string> g = grid;
+    for (const auto& w : res.walls) {
+        if (w.first < 0 || w.first >= R || w.second < 0 || w.second >= C) {
+            return "wall out of bounds";
+        }
+        char& ch = g[static_cast<size_t>(w.first)][static_cast<size_t>(w.second)];
+        if (ch != '.') {
+            return "wall on non-empty cell (" + std::to_string(w.first) + ", " + std::to_string(w.second) + ")";
+        }
+        ch = 'X';
+    }
+    if (res.best_area == 0) return "";
+
+    int hr = -1, hc = -1;
+    for (int r = 0; r < R && hr < 0; r++) {
+        size_t c = g[static_cast<size_t>(r)].find('H');
+        if (c != string::npos) { hr = r; hc = static_cast<int>(c); }
+    }
+    if (hr < 0) return "no horse";
+
+    vector<vector<char>> seen(static_cast<size_t>(R), vector<char>(static_cast<size_t>(C), 0));
+    std::deque<pair<int,int>> q;
+    q.push_back({hr, hc});
+    seen[static_cast<size_t>(hr)][static_cast<size_t>(hc)] = 1;
+    int area = 0;
+    bool escapes = false;
+    const int drs[4] = {1, -1, 0, 0};
+    const int dcs[4] = {0, 0, 1, -1};
+    while (!q.empty()) {
+        pair<int,int> cur = q.front();
+        q.pop_front();
+        area++;
+        if (cur.first == 0 || cur.first == R - 1 || cur.second == 0 || cur.second == C - 1) escapes = true;
+        for (int d = 0; d < 4; d++) {
+            int nr = cur.first + drs[d], nc = cur.second + dcs[d];
+            if (nr < 0 || nr >= R || nc < 0 || nc >= C) continue;
+            if (seen[static_cast<size_t>(nr)][static_cast<size_t>(nc)]) continue;
+            if (!is_open_cell(g[static_cast<size_t>(nr)][static_cast<size_t>(nc)])) continue;
+            seen[static_cast<size_t>(nr)][static_cast<size_t>(nc)] = 1;
+            q.push_back({nr, nc});
+        }
+    }
+    if (escapes) return "horse escapes through the walls";
+    if (area != res.best_area) {
+        return "walls enclose " + std::to_string(area) + " cells, reported " + std::to_string(res.best_area);
+    }
+    return "";
+}
+
+} // namespace oracle
+} // namespace enclose
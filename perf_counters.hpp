@@ -0,0 +1,139 @@
+#pragma once
+
+// perf_counters.hpp - Hardware performance counters via Linux perf_event_open
+// Counts user-space cycles, instructions, L1D read misses, LLC misses and
+// branch misses for the calling thread. Each counter is opened on its own, so
+// an event the PMU or container refuses is reported as unavailable without
+// disabling the others; on non-Linux platforms nothing is available.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace enclose {
+
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+inline const char* perf_event_name(int e) {
+    static const char* names[PERF_EVENT_COUNT] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+    return names[e];
+}
+
+struct PerfSample {
+    bool valid[PERF_EVENT_COUNT] = {};
+    double value[PERF_EVENT_COUNT] = {};   // scaled for multiplexing
+};
+
+class PerfCounters {
+public:
+    PerfCounters() {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) fd_[e] = -1;
+#ifdef __linux__
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            switch (e) {
+            case PERF_CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PERF_INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PERF_L1D_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case PERF_LLC_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PERF_BRANCH_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            }
+            fd_[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd_[e] < 0 && error_.empty()) error_ = std::strerror(errno);
+        }
+#else
+        error_ = "perf_event_open is Linux-only";
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (fd_[e] >= 0) close(fd_[e]);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available(int e) const { return fd_[e] >= 0; }
+    bool any_available() const {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (available(e)) return true;
+        }
+        return false;
+    }
+    // Reason the first unavailable counter failed to open (empty if all opened)
+    const std::string& error() const { return error_; }
+
+    void start() {
+#ifdef __linux__
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (fd_[e] < 0) continue;
+            ioctl(fd_[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample s;
+#ifdef __linux__
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (fd_[e] < 0) continue;
+            ioctl(fd_[e], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t buf[3] = {0, 0, 0};   // value, time_enabled, time_running
+            if (read(fd_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+            if (buf[2] == 0) continue;      // never scheduled on the PMU
+            s.valid[e] = true;
+            s.value[e] = static_cast<double>(buf[0]) * static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+        }
+#endif
+        return s;
+    }
+
+private:
+    int fd_[PERF_EVENT_COUNT];
+    std::string error_;
+};
+
+} // namespace enclose
@@ -0,0 +1,324 @@
+#pragma once
+
+// server.hpp - Long-running solver service over a Unix domain socket (POSIX only)
+//
+// Protocol: newline-delimited JSON. Each request line is an object
+//   {"id": ..., "grid": "..." | [rows], "k": 6, "deadline_ms": 2000}
+// and produces one response line on the same connection:
+//   {"id": ..., "area": N, "walls": [[r,c],...], "time_ms": T, "cached": bool, "timed_out": bool}
+// or {"id": ..., "error": "..."}. Responses may arrive out of order; match them by id.
+// deadline_ms is checked before each search node, so a solve can overrun it by the
+// time of one node (one max-flow; tens of ms on the largest boards).
+// A line longer than Options::max_line_bytes is answered with an error (id null)
+// and the connection is closed.
+// {"cmd": "stats"} reports cache counters, {"cmd": "ping"} answers {"ok": true}.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "batch.hpp"
+#include "cache.hpp"
+#include "json.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+
+namespace enclose {
+namespace server {
+
+using std::string;
+
+struct Options {
+    string socket_path;
+    int threads = 1;
+    int default_k = 6;
+    double default_deadline_ms = 0.0;   // 0 = no deadline unless the request sets one
+    size_t cache_entries = 4096;
+    size_t max_line_bytes = size_t(4) << 20;   // longer request lines get an error and close the connection
+    ResultStore* store = nullptr;        // optional persistent cache behind the LRU
+    SolveOptions solve;                  // for every request; the deadline is set per request
+};
+
+namespace detail {
+
+inline volatile std::sig_atomic_t& stop_flag() {
+    static volatile std::sig_atomic_t flag = 0;
+    return flag;
+}
+
+extern "C" inline void on_signal(int) {
+    stop_flag() = 1;
+}
+
+struct Connection {
+    int fd;
+    std::mutex write_mu;
+
+    explicit Connection(int fd_) : fd(fd_) {}
+    ~Connection() { ::close(fd); }
+
+    void send(const string& line) {
+        std::lock_guard<std::mutex> lk(write_mu);
+        string buf = line + "\n";
+        const char* p = buf.data();
+        size_t left = buf.size();
+        while (left > 0) {
+            ssize_t n = ::send(fd, p, left, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;   // peer went away; drop the response
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+    }
+};
+
+inline void write_id(std::ostream& os, const json::Value& id) {
+    os << "{\"id\":";
+    json::write(os, id);
+}
+
+inline string error_response(const json::Value& id, const string& msg) {
+    std::ostringstream os;
+    write_id(os, id);
+    os << ",\"error\":" << json::quote(msg) << "}";
+    return os.str();
+}
+
+inline string result_response(const json::Value& id, const SolveResult& res, double ms, bool cached) {
+    std::ostringstream os;
+    write_id(os, id);
+    os << ",\"area\":" << res.best_area << ",\"walls\":";
+    batch::write_walls(os, res.walls);
+    os << ",\"time_ms\":" << ms
+       << ",\"cached\":" << (cached ? "true" : "false")
+       << ",\"timed_out\":" << (res.timed_out ? "true" : "false") << "}";
+    return os.str();
+}
+
+class Server {
+public:
+    explicit Server(const Options& opt)
+        : opt_(opt), pool_(opt.threads, static_cast<size_t>(opt.threads) * 16), cache_(opt.cache_entries) {}
+
+    // Serve one connection until the peer closes it or the server stops
+    void serve_connection(std::shared_ptr<Connection> conn) {
+        string buf;
+        char chunk[4096];
+        while (!stop_flag()) {
+            ssize_t n = ::recv(conn->fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            buf.append(chunk, static_cast<size_t>(n));
+            size_t start = 0;
+            for (size_t nl = buf.find('\n', start); nl != string::npos; nl = buf.find('\n', start)) {
+                string line = buf.substr(start, nl - start);
+                start = nl + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.find_first_not_of(" \t") == string::npos) continue;
+                handle_line(conn, line);
+            }
+            buf.erase(0, start);
+            if (buf.size() > opt_.max_line_bytes) {
+                conn->send(error_response(json::Value(), "request line too long"));
+                break;
+            }
+        }
+    }
+
+    void wait_idle() { pool_.wait_idle(); }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    Options opt_;
+    ThreadPool pool_;
+    LruCache cache_;
+
+    void handle_line(const std::shared_ptr<Connection>& conn, const string& line) {
+        auto received = clock::now();
+        json::Value req;
+        try {
+            req = json::parse(line);
+        } catch (const std::exception& e) {
+            conn->send(error_response(json::Value(), e.what()));
+            return;
+        }
+
+        json::Value id;
+        if (const json::Value* v = req.find("id")) id = *v;
+
+        if (const json::Value* cmd = req.find("cmd")) {
+            std::ostringstream os;
+            write_id(os, id);
+            if (cmd->is_string() && cmd->str == "ping") {
+                os << ",\"ok\":true}";
+            } else if (cmd->is_string() && cmd->str == "stats") {
+                os << ",\"cache_entries\":" << cache_.size()
+                   << ",\"cache_hits\":" << cache_.hits()
+                   << ",\"cache_misses\":" << cache_.misses()
+                   << ",\"threads\":" << pool_.size() << "}";
+            } else {
+                conn->send(error_response(id, "unknown cmd"));
+                return;
+            }
+            conn->send(os.str());
+            return;
+        }
+
+        batch::Puzzle p;
+        p.k = opt_.default_k;
+        double deadline_ms = opt_.default_deadline_ms;
+        try {
+            batch::read_record(req, p);
+            if (const json::Value* d = req.find("deadline_ms")) {
+                if (!d->is_number() || !std::isfinite(d->num) || d->num < 0) {
+                    throw std::runtime_error("\"deadline_ms\" must be a non-negative number");
+                }
+                // past ~30 years the clock arithmetic below would overflow
+                deadline_ms = std::min(d->num, 1e12);
+            }
+        } catch (const std::exception& e) {
+            conn->send(error_response(id, e.what()));
+            return;
+        }
+
+        CanonicalGrid cg = canonicalize(p.grid);
+        CacheKey key = make_cache_key(cg, p.k);
+        SolveResult cached;
+        bool hit = cache_.get(key, cached);
+        if (!hit && opt_.store && opt_.store->get(key, cached)) {
+            cache_.put(key, cached);
+            hit = true;
+        }
+        if (hit) {
+            cached.walls = cg.from_canonical(cached.walls);
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - received).count();
+            conn->send(result_response(id, cached, ms, true));
+            return;
+        }
+
+        SolveOptions sopt = opt_.solve;
+        if (deadline_ms > 0) {
+            sopt.deadline = received + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double, std::milli>(deadline_ms));
+        }
+
+        pool_.submit([this, conn, p, id, cg, key, sopt, received]() {
+            if (clock::now() >= sopt.deadline) {
+                conn->send(error_response(id, "deadline exceeded before start"));
+                return;
+            }
+            try {
+                SolveResult res = solve(p.k, p.grid, sopt);
+                if (!res.timed_out) {
+                    SolveResult stored = res;
+                    stored.walls = cg.to_canonical(res.walls);
+                    cache_.put(key, stored);
+                    if (opt_.store) opt_.store->put(key, stored);
+                }
+                double ms = std::chrono::duration<double, std::milli>(clock::now() - received).count();
+                conn->send(result_response(id, res, ms, false));
+            } catch (const std::exception& e) {
+                conn->send(error_response(id, e.what()));
+            }
+        });
+    }
+};
+
+} // namespace detail
+
+// Bind the socket and serve until SIGINT/SIGTERM. Returns a process exit code.
+inline int run(const Options& opt) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (opt.socket_path.empty() || opt.socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "serve: invalid socket path\n";
+        return 2;
+    }
+    std::strncpy(addr.sun_path, opt.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        std::cerr << "serve: socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    ::unlink(opt.socket_path.c_str());
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(lfd, 64) < 0) {
+        std::cerr << "serve: bind/listen " << opt.socket_path << ": " << std::strerror(errno) << "\n";
+        ::close(lfd);
+        return 1;
+    }
+
+    std::signal(SIGINT, detail::on_signal);
+    std::signal(SIGTERM, detail::on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cerr << "serve: listening on " << opt.socket_path << " with " << opt.threads << " threads\n";
+
+    detail::Server server(opt);
+
+    struct Client {
+        std::thread thread;
+        std::shared_ptr<detail::Connection> conn;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::list<Client> clients;
+
+    while (!detail::stop_flag()) {
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->done->load()) {
+                it->thread.join();
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd pfd{lfd, POLLIN, 0};
+        int pr = ::poll(&pfd, 1, 200);
+        if (pr <= 0) continue;
+
+        int cfd = ::accept(lfd, nullptr, nullptr);
+        if (cfd < 0) continue;
+
+        Client c;
+        c.conn = std::make_shared<detail::Connection>(cfd);
+        c.done = std::make_shared<std::atomic<bool>>(false);
+        auto conn = c.conn;
+        auto done = c.done;
+        c.thread = std::thread([&server, conn, done]() {
+            server.serve_connection(conn);
+            done->store(true);
+        });
+        clients.push_back(std::move(c));
+    }
+
+    ::close(lfd);
+    ::unlink(opt.socket_path.c_str());
+    for (auto& c : clients) ::shutdown(c.conn->fd, SHUT_RDWR);
+    for (auto& c : clients) c.thread.join();
+    server.wait_idle();
+    std::cerr << "serve: stopped\n";
+    return 0;
+}
+
+} // namespace server
+} // namespace enclose
@@ -1,10 +1,15 @@
 // solve2.cpp - Native command-line solver
-// Compile with: clang++ -O2 -std=c++17 -o solve2 solve2.cpp
+// Compile with: clang++ -O2 -std=c++17 -pthread -o solve2 solve2.cpp
 
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "batch.hpp"
+#include "cache.hpp"
+#include "capture.hpp"
+#include "server.hpp"
 #include "solver.hpp"
 
 using std::string;
@@ -12,7 +17,7 @@ using std::vector;
 
 /* ---------------- Output ---------------- */
 
-void print_ans(int area, const vector<std::pair<int,int>>& walls, const vector<string>& grid_original) {
+void print_walls(int area, const vector<std::pair<int,int>>& walls) {
     std::cout << "max enclosed area: " << area << "\n";
     std::cout << "walls: [";
     for (size_t i = 0; i < walls.size(); i++) {
@@ -20,6 +25,10 @@ void print_ans(int area, const vector<std::pair<int,int>>& walls, const vector<s
         std::cout << "(" << walls[i].first << ", " << walls[i].second << ")";
     }
     std::cout << "]\n";
+}
+
+void print_ans(int area, const vector<std::pair<int,int>>& walls, const vector<string>& grid_original) {
+    print_walls(area, walls);
 
     vector<string> g = grid_original;
     for (const auto& rc : walls) {
@@ -28,6 +37,13 @@ void print_ans(int area, const vector<std::pair<int,int>>& walls, const vector<s
     for (const auto& row : g) std::cout << row << "\n";
 }
 
+void print_stats(const enclose::SolveStats& st) {
+    std::cout << "stats:\n";
+    st.for_each([](const char* name, auto value) {
+        std::cout << "  " << name << ": " << value << "\n";
+    });
+}
+
 /* ---------------- main ---------------- */
 
 int main(int argc, char** argv) {
@@ -35,11 +51,147 @@ int main(int argc, char** argv) {
     std::cin.tie(nullptr);
 
     int k = 6;
+    bool batch_mode = false;
+    enclose::batch::Options batch_opt;
+    batch_opt.threads = enclose::ThreadPool::default_threads();
+    enclose::server::Options serve_opt;
+    string cache_path;
+    enclose::SolveOptions solve_opt;
+    string trace_path;
+    unsigned trace_sample = 64;
+    string capture_path;
+    bool large = false;
+    string corpus_path;
+
     for (int i = 1; i < argc; i++) {
         string a = argv[i];
         if (a == "-k" && i + 1 < argc) {
             k = std::stoi(argv[++i]);
+        } else if (a == "--stats") {
+            solve_opt.collect_stats = true;
+        } else if (a == "--branching" && i + 1 < argc) {
+            string b = argv[++i];
+            if (!enclose::parse_branching(b, solve_opt.branching)) {
+                std::cerr << "unknown --branching: " << b << " (sink-cut, min-cuts)\n";
+                return 2;
+            }
+        } else if (a == "--flow-engine" && i + 1 < argc) {
+            string e = argv[++i];
+            if (!enclose::parse_flow_engine(e, solve_opt.flow_engine)) {
+                std::cerr << "unknown --flow-engine: " << e << " (auto, ek, bk, pr)\n";
+                return 2;
+            }
+        } else if (a == "--nogoods") {
+            solve_opt.learn_nogoods = true;
+        } else if (a == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (a == "--trace-sample" && i + 1 < argc) {
+            trace_sample = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (a == "--cell-order" && i + 1 < argc) {
+            string o = argv[++i];
+            if (!enclose::parse_cell_order(o, solve_opt.cell_order)) {
+                std::cerr << "unknown --cell-order: " << o << " (bfs, row-major, morton, hilbert)\n";
+                return 2;
+            }
+        } else if (a == "--capture" && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (a == "--large") {
+            large = true;
+        } else if (a == "--corpus" && i + 1 < argc) {
+            corpus_path = argv[++i];
+            batch_mode = true;
+        } else if (a == "--batch") {
+            batch_mode = true;
+        } else if ((a == "-j" || a == "--threads") && i + 1 < argc) {
+            batch_opt.threads = std::stoi(argv[++i]);
+        } else if (a == "--serve" && i + 1 < argc) {
+            serve_opt.socket_path = argv[++i];
+        } else if (a == "--deadline-ms" && i + 1 < argc) {
+            serve_opt.default_deadline_ms = std::stod(argv[++i]);
+        } else if (a == "--cache-entries" && i + 1 < argc) {
+            serve_opt.cache_entries = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (a == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (a == "--order" && i + 1 < argc) {
+            string o = argv[++i];
+            if (o == "input") {
+                batch_opt.order = enclose::batch::OutputOrder::Input;
+            } else if (o == "completion") {
+                batch_opt.order = enclose::batch::OutputOrder::Completion;
+            } else {
+                std::cerr << "unknown --order: " << o << " (expected input or completion)\n";
+                return 2;
+            }
+        }
+    }
+
+    enclose::TraceRecorder trace(trace_sample);
+    if (!trace_path.empty()) solve_opt.trace = &trace;
+    auto write_trace = [&]() {
+        if (trace_path.empty()) return;
+        std::ofstream tf(trace_path);
+        trace.write_json(tf);
+        if (!tf) std::cerr << "cannot write trace " << trace_path << "\n";
+    };
+
+    enclose::ResultStore store;
+    if (!cache_path.empty()) {
+        if (!store.open(cache_path)) {
+            std::cerr << "cannot open cache " << cache_path << "\n";
+            return 1;
         }
+        serve_opt.store = &store;
+        batch_opt.store = &store;
+    }
+
+    if (!serve_opt.socket_path.empty()) {
+        serve_opt.threads = batch_opt.threads;
+        serve_opt.default_k = k;
+        serve_opt.solve = solve_opt;
+        serve_opt.solve.trace = nullptr;   // the server never stops to write it
+        return enclose::server::run(serve_opt);
+    }
+
+    if (batch_mode) {
+        batch_opt.default_k = k;
+        batch_opt.collect_stats = solve_opt.collect_stats;
+        batch_opt.trace = solve_opt.trace;
+        batch_opt.cell_order = solve_opt.cell_order;
+        batch_opt.learn_nogoods = solve_opt.learn_nogoods;
+        batch_opt.branching = solve_opt.branching;
+        batch_opt.flow_engine = solve_opt.flow_engine;
+        enclose::batch::Summary sum;
+        if (!corpus_path.empty()) {
+            try {
+                enclose::Corpus corpus(corpus_path);
+                sum = enclose::batch::run_corpus(corpus, std::cout, batch_opt);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else {
+            sum = enclose::batch::run(std::cin, std::cout, batch_opt);
+        }
+        write_trace();
+        std::cerr << "batch: " << sum.puzzles << " puzzles, " << sum.failed << " failed, "
+                  << sum.wall_ms << " ms, " << batch_opt.threads << " threads\n";
+        return sum.failed ? 1 : 0;
+    }
+
+    if (large) {
+        // Stream rows straight into 2-bit cells; the text is never held whole
+        enclose::PackedGrid pg;
+        string row;
+        while (std::getline(std::cin, row)) {
+            if (!row.empty() && row.back() == '\r') row.pop_back();
+            if (!row.empty()) pg.push_row(row);
+        }
+        if (pg.R == 0) return 0;
+        enclose::SolveResult res = enclose::solve(k, pg.view(), solve_opt);
+        print_walls(res.best_area, res.walls);
+        if (res.has_stats) print_stats(res.stats);
+        write_trace();
+        return 0;
     }
 
     vector<string> lines;
@@ -56,7 +208,19 @@ int main(int argc, char** argv) {
     }
     if (grid.empty()) return 0;
 
-    enclose::SolveResult res = enclose::solve(k, grid);
+    enclose::KernelCapture capture;
+    if (!capture_path.empty()) solve_opt.capture = &capture;
+
+    enclose::SolveResult res = cache_path.empty()
+        ? enclose::solve(k, grid, solve_opt)
+        : enclose::solve_cached(k, grid, solve_opt, store);
     print_ans(res.best_area, res.walls, grid);
+    if (res.has_stats) print_stats(res.stats);
+    write_trace();
+    if (!capture_path.empty()) {
+        std::ofstream cf(capture_path);
+        enclose::write_capture(cf, grid, k, capture);
+        if (!cf) std::cerr << "cannot write capture " << capture_path << "\n";
+    }
     return 0;
 }
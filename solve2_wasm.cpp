@@ -10,11 +10,29 @@
 
 #include <emscripten/bind.h>
 
+#include "cache.hpp"
 #include "solver.hpp"
 
 using std::string;
 using std::vector;
 
+// Results of earlier solves in this module instance, keyed by the board's
+// symmetry-canonical form, so re-submitted (even rotated or mirrored) boards
+// skip the search. Memory-only, holding the ResultStore::MEMORY_ENTRIES
+// most recent results.
+static enclose::ResultStore& resultStore() {
+    static enclose::ResultStore store;
+    return store;
+}
+
+// Min separators of the board solved last. Changing only k in the UI
+// re-solves the same board, and most of the flows are answered from here.
+static enclose::SeparatorCache& separatorCache() {
+    static enclose::SeparatorCache cache;
+    cache.max_entries = size_t(1) << 18;
+    return cache;
+}
+
 /* ---------------- WASM Interface ---------------- */
 
 // Parse grid string (newline separated) into vector<string>
@@ -114,18 +132,34 @@ string solveGrid(const string& gridStr, int k) {
             return R"({"error": "Empty grid"})";
         }
 
-        enclose::SolveResult res = enclose::solve(k, grid);
+        // Counters are cheap next to the search itself, so the web build always reports them
+        enclose::SolveOptions opt;
+        opt.collect_stats = true;
+        opt.separator_cache = &separatorCache();
+        bool cached = false;
+        enclose::SolveResult res = enclose::solve_cached(k, grid, opt, resultStore(), &cached);
 
         // Build JSON response manually
         std::ostringstream json;
         json << "{";
         json << "\"area\": " << res.best_area << ",";
+        json << "\"cached\": " << (cached ? "true" : "false") << ",";
         json << "\"walls\": [";
         for (size_t i = 0; i < res.walls.size(); i++) {
             if (i > 0) json << ",";
             json << "[" << res.walls[i].first << "," << res.walls[i].second << "]";
         }
         json << "],";
+        if (res.has_stats) {
+            json << "\"stats\": {";
+            bool first = true;
+            res.stats.for_each([&](const char* name, auto value) {
+                if (!first) json << ",";
+                first = false;
+                json << "\"" << name << "\": " << value;
+            });
+            json << "},";
+        }
         json << "\"solvedGrid\": \"";
 
         string solvedGrid = buildSolvedGrid(grid, res.walls);
@@ -4,25 +4,24 @@
 // Include this in both native (solve2.cpp) and WASM (solve2_wasm.cpp) builds
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <deque>
-#include <functional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "trace.hpp"
+
 namespace enclose {
 
 using std::deque;
-using std::function;
 using std::pair;
 using std::size_t;
 using std::string;
 using std::unordered_map;
-using std::unordered_set;
 using std::vector;
 
 /* ---------------- DynamicBitset (vector<uint64_t> based) ---------------- */
@@ -120,6 +119,40 @@ struct DynamicBitset {
     }
 };
 
+/* ---------------- CellSet (sorted small array) ---------------- */
+
+// Sparse set of cell ids for the DFS state. `deleted` holds at most k cells
+// and `forced` a handful, so a sorted array is far smaller to copy and store
+// in the memo than an N-bit DynamicBitset. Exposes the same read interface
+// (test, for_each_set_bit, empty) so kernels can take either.
+struct CellSet {
+    vector<int> ids;   // strictly increasing
+
+    inline bool test(int i) const {
+        return std::binary_search(ids.begin(), ids.end(), i);
+    }
+    inline bool empty() const { return ids.empty(); }
+    inline int size() const { return static_cast<int>(ids.size()); }
+
+    // Copy with i added (i must not be present)
+    inline CellSet with(int i) const {
+        CellSet r;
+        r.ids.reserve(ids.size() + 1);
+        auto pos = std::lower_bound(ids.begin(), ids.end(), i);
+        r.ids.insert(r.ids.end(), ids.begin(), pos);
+        r.ids.push_back(i);
+        r.ids.insert(r.ids.end(), pos, ids.end());
+        return r;
+    }
+
+    template <class F>
+    inline void for_each_set_bit(F&& f) const {
+        for (int i : ids) f(i);
+    }
+
+    bool operator==(const CellSet& other) const { return ids == other.ids; }
+};
+
 /* ---------------- Hash helpers ---------------- */
 
 inline uint64_t splitmix64(uint64_t x) {
@@ -140,58 +173,95 @@ struct BitsetHash {
     }
 };
 
+struct CellSetHash {
+    size_t operator()(const CellSet& s) const noexcept {
+        uint64_t h = splitmix64(static_cast<uint64_t>(s.ids.size()));
+        for (int i : s.ids) h = splitmix64(h ^ static_cast<uint64_t>(i));
+        return static_cast<size_t>(h);
+    }
+};
+
+// Memo key; the budget is the mapped value, so a state explored with a
+// larger k_rem dominates revisits with the same or a smaller one
 struct State {
-    DynamicBitset deleted;
-    DynamicBitset forced;
-    int k_rem = 0;
+    CellSet deleted;
+    CellSet forced;
 
     bool operator==(const State& o) const {
-        return k_rem == o.k_rem && deleted == o.deleted && forced == o.forced;
+        return deleted == o.deleted && forced == o.forced;
     }
 };
 
 struct StateHash {
     size_t operator()(const State& s) const noexcept {
-        BitsetHash bh;
+        CellSetHash bh;
         uint64_t h = static_cast<uint64_t>(bh(s.deleted));
         h ^= splitmix64(static_cast<uint64_t>(bh(s.forced)) + 0x123456789abcdef0ULL);
-        h ^= splitmix64(static_cast<uint64_t>(s.k_rem));
         return static_cast<size_t>(h);
     }
 };
 
+/* ---------------- Compact adjacency ---------------- */
+
+// Read-only [begin, end) view of one node's slice of a CSR id array. Graphs
+// keep all lists in one 32-bit array plus N+1 offsets instead of a vector
+// per node, which on million-cell boards is most of the setup memory.
+struct IdRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+};
+
 /* ---------------- FlowTemplate ---------------- */
 
+// Topology of a flow network. Edge e and its reverse e ^ 1 are added as a
+// pair, so the reverse and the tail (to[e ^ 1]) need no arrays of their own,
+// and the edges entering v are the reverses of those leaving it. Capacities
+// live in the caller's vector, indexed by edge id.
 struct FlowTemplate {
     int n;
-    vector<vector<int>> adj;
-    vector<vector<int>> in_adj;
-    vector<int> to, frm, rev;
-    vector<int> base_cap;
+    vector<int> to;
+    vector<int> adj_start;   // CSR of edge ids leaving each node, set by finalize()
+    vector<int> adj_list;
 
-    explicit FlowTemplate(int n_) : n(n_), adj(static_cast<size_t>(n_)), in_adj(static_cast<size_t>(n_)) {}
+    explicit FlowTemplate(int n_) : n(n_) {}
 
-    int add_edge(int u, int v, int c) {
+    // Optional pre-sizing before add_edge: `edges` forward edges in total
+    void reserve_edges(size_t edges) {
+        to.reserve(2 * edges);
+    }
+
+    int add_edge(int u, int v) {
         int idx = static_cast<int>(to.size());
         to.push_back(v);
-        frm.push_back(u);
-        rev.push_back(idx + 1);
-        base_cap.push_back(c);
         to.push_back(u);
-        frm.push_back(v);
-        rev.push_back(idx);
-        base_cap.push_back(0);
-
-        adj[static_cast<size_t>(u)].push_back(idx);
-        adj[static_cast<size_t>(v)].push_back(idx + 1);
+        return idx;
+    }
 
-        in_adj[static_cast<size_t>(v)].push_back(idx);
-        in_adj[static_cast<size_t>(u)].push_back(idx + 1);
+    // Build the per-node edge lists once all edges are added. Each list is in
+    // edge id order.
+    void finalize() {
+        adj_start.assign(static_cast<size_t>(n) + 1, 0);
+        for (size_t e = 0; e < to.size(); e++) adj_start[static_cast<size_t>(to[e ^ 1]) + 1]++;
+        for (int u = 0; u < n; u++) adj_start[static_cast<size_t>(u) + 1] += adj_start[static_cast<size_t>(u)];
+        adj_list.resize(to.size());
+        vector<int> fill(adj_start.begin(), adj_start.end() - 1);
+        for (size_t e = 0; e < to.size(); e++) {
+            adj_list[static_cast<size_t>(fill[static_cast<size_t>(to[e ^ 1])]++)] = static_cast<int>(e);
+        }
+    }
 
-        return idx;
+    IdRange edges(int u) const {
+        return {adj_list.data() + adj_start[static_cast<size_t>(u)], adj_list.data() + adj_start[static_cast<size_t>(u) + 1]};
     }
 
-    int maxflow_limit(int s, int t, vector<int>& cap, int limit) const {
+    // Edmonds-Karp with unit augmentations, stopping once `limit` paths are
+    // found. Cap is any signed type that holds the network's INF.
+    template <class Cap>
+    int maxflow_limit(int s, int t, vector<Cap>& cap, int limit) const {
         int flow = 0;
         vector<int> parent(static_cast<size_t>(n), -1);
 
@@ -204,7 +274,7 @@ struct FlowTemplate {
             while (!q.empty() && parent[static_cast<size_t>(t)] == -1) {
                 int u = q.front();
                 q.pop_front();
-                for (int e : adj[static_cast<size_t>(u)]) {
+                for (int e : edges(u)) {
                     if (cap[static_cast<size_t>(e)] <= 0) continue;
                     int v = to[static_cast<size_t>(e)];
                     if (parent[static_cast<size_t>(v)] != -1) continue;
@@ -223,8 +293,8 @@ struct FlowTemplate {
             while (v != s) {
                 int e = parent[static_cast<size_t>(v)];
                 cap[static_cast<size_t>(e)] -= 1;
-                cap[static_cast<size_t>(rev[static_cast<size_t>(e)])] += 1;
-                v = frm[static_cast<size_t>(e)];
+                cap[static_cast<size_t>(e ^ 1)] += 1;
+                v = to[static_cast<size_t>(e ^ 1)];
             }
             flow += 1;
         }
@@ -232,164 +302,1179 @@ struct FlowTemplate {
     }
 };
 
-/* ---------------- Solver Result ---------------- */
+// Takes units of flow back out of a network whose edges were added with zero
+// reverse capacity, so the flow on forward (even) edge e is cap[e ^ 1]
+class FlowWalker {
+public:
+    explicit FlowWalker(const FlowTemplate& f) : f_(f) {}
+
+    // From x, follow flow-carrying edges backward (into x) or forward until
+    // stop_a or stop_b, then call unpush(e) to take one unit off every edge
+    // e walked. Cycles met on the way are cancelled as they close. Returns
+    // the stop reached.
+    template <class Cap, class Unpush>
+    int cancel(const vector<Cap>& cap, int x, bool backward, int stop_a, int stop_b, Unpush&& unpush) {
+        int taken = 1;
+        return walk(cap, x, backward, stop_a, stop_b, false, [&](int e, int) { unpush(e); }, taken);
+    }
 
-struct SolveResult {
-    int best_area = 0;
-    vector<pair<int,int>> walls;
+    // As cancel with stop_a == stop_b == stop, but in bulk: each cycle loses
+    // its smallest flow as it closes, and the walk up to `amount` units.
+    // unpush(e, d) takes d units off e. Returns the units taken off the walk.
+    template <class Cap, class Unpush>
+    int cancel_up_to(const vector<Cap>& cap, int x, bool backward, int stop, int amount, Unpush&& unpush) {
+        int taken = amount;
+        walk(cap, x, backward, stop, stop, true, unpush, taken);
+        return taken;
+    }
+
+private:
+    // taken is the units to take off the walk, lowered to its smallest flow
+    // if bulk. The flow on e is cap[e ^ 1], as edges start with none in
+    // reverse.
+    template <class Cap, class Unpush>
+    int walk(const vector<Cap>& cap, int x, bool backward, int stop_a, int stop_b, bool bulk, Unpush&& unpush,
+             int& taken) {
+        if (on_walk_.empty()) on_walk_.assign(static_cast<size_t>(f_.n), -1);
+        auto carried = [&](int e) { return static_cast<int>(cap[static_cast<size_t>(e ^ 1)]); };
+        edges_.clear();
+        nodes_.assign(1, x);
+        on_walk_[static_cast<size_t>(x)] = 0;
+        while (x != stop_a && x != stop_b) {
+            int next = -1, y = -1;
+            for (int e : f_.edges(x)) {
+                // odd e leaving x is the reverse of a forward edge into x
+                bool carries = backward ? ((e & 1) && cap[static_cast<size_t>(e)] > 0)
+                                        : (!(e & 1) && cap[static_cast<size_t>(e ^ 1)] > 0);
+                if (carries) {
+                    next = backward ? (e ^ 1) : e;
+                    y = f_.to[static_cast<size_t>(e)];
+                    break;
+                }
+            }
+            if (next < 0) break;   // unreachable for a conserved flow
+            int at = on_walk_[static_cast<size_t>(y)];
+            if (at >= 0) {
+                int d = 1;
+                if (bulk) {
+                    d = carried(next);
+                    for (size_t j = static_cast<size_t>(at); j < edges_.size(); j++) d = std::min(d, carried(edges_[j]));
+                }
+                unpush(next, d);
+                for (size_t j = static_cast<size_t>(at); j < edges_.size(); j++) unpush(edges_[j], d);
+                for (size_t j = static_cast<size_t>(at) + 1; j < nodes_.size(); j++) {
+                    on_walk_[static_cast<size_t>(nodes_[j])] = -1;
+                }
+                edges_.resize(static_cast<size_t>(at));
+                nodes_.resize(static_cast<size_t>(at) + 1);
+                x = y;
+                continue;
+            }
+            on_walk_[static_cast<size_t>(y)] = static_cast<int>(nodes_.size());
+            edges_.push_back(next);
+            nodes_.push_back(y);
+            x = y;
+        }
+        if (bulk) {
+            for (int e : edges_) taken = std::min(taken, carried(e));
+        }
+        for (int e : edges_) unpush(e, taken);
+        for (int v : nodes_) on_walk_[static_cast<size_t>(v)] = -1;
+        return x;
+    }
+
+    const FlowTemplate& f_;
+    vector<int> on_walk_;   // position on the current walk, or -1
+    vector<int> edges_;
+    vector<int> nodes_;
 };
 
-/* ---------------- Solver Implementation ---------------- */
+/* ---------------- Boykov-Kolmogorov ---------------- */
+
+// Boykov-Kolmogorov max flow on a FlowTemplate. A search tree grows from
+// each terminal; after an augmentation only the nodes cut off from their
+// tree (orphans) are re-attached, so no search starts over. A run that
+// stops below its limit leaves both trees maximal: the source tree is the
+// residual source side and the sink tree the residual sink side, so no
+// extra BFS is needed for the cut. The trees live in State, and a saved
+// State can be resumed after raise() or cut() change a few edges; the next
+// run repairs the trees around them instead of growing them again.
+// Edges must be added with zero reverse capacity (see FlowWalker).
+template <class Cap>
+class BkFlow {
+public:
+    enum : unsigned char { FREE = 0, SOURCE = 1, SINK = 2 };
+    enum : int { NONE = -1, ROOT = -2 };
+
+    struct State {
+        vector<Cap> cap;              // residual capacities
+        vector<unsigned char> tree;   // FREE, SOURCE or SINK
+        vector<int> parent;           // edge leaving the node toward its tree parent, or NONE / ROOT
+        int flow = 0;
+    };
+    State state;
+
+    BkFlow(const FlowTemplate& f, int s, int t) : f_(f), s_(s), t_(t), walker_(f) {}
+
+    // Fresh trees over `cap` (swapped in) with zero flow
+    void start(vector<Cap>& cap) {
+        prepare();
+        state.cap.swap(cap);
+        state.tree.assign(static_cast<size_t>(f_.n), FREE);
+        state.parent.assign(static_cast<size_t>(f_.n), NONE);
+        state.tree[static_cast<size_t>(s_)] = SOURCE;
+        state.tree[static_cast<size_t>(t_)] = SINK;
+        state.parent[static_cast<size_t>(s_)] = ROOT;
+        state.parent[static_cast<size_t>(t_)] = ROOT;
+        state.flow = 0;
+        activate(s_);
+        activate(t_);
+    }
+
+    // Continue from a State assigned to `state` by the caller, saved after
+    // a run that stopped below its limit
+    void resume() { prepare(); }
+
+    // Add `amount` to the residual capacity of e
+    void raise(int e, int amount) {
+        if (amount <= 0) return;
+        state.cap[static_cast<size_t>(e)] = static_cast<Cap>(state.cap[static_cast<size_t>(e)] + amount);
+        raised(e);
+    }
+
+    // Cancel the flow through forward edge e and give it zero capacity.
+    // Each unit is traced back to the source and on to the sink (or around
+    // a cycle) along flow-carrying edges; state.flow drops accordingly.
+    void cut(int e) {
+        const int u = f_.to[static_cast<size_t>(e ^ 1)];
+        const int w = f_.to[static_cast<size_t>(e)];
+        auto unpush_one = [&](int x) { unpush(x); };
+        while (state.cap[static_cast<size_t>(e ^ 1)] > 0) {
+            unpush(e);   // excess at u, deficit at w
+            if (walker_.cancel(state.cap, u, true, s_, w, unpush_one) != s_) continue;
+            walker_.cancel(state.cap, w, false, t_, t_, unpush_one);
+            state.flow--;
+        }
+        if (state.cap[static_cast<size_t>(e)] > 0) {
+            state.cap[static_cast<size_t>(e)] = 0;
+            lowered(e);
+        }
+        adopt();
+    }
+
+    // Augment from the current trees until the flow reaches `limit` or no
+    // path is left; returns state.flow
+    int run(int limit) {
+        while (state.flow < limit) {
+            int m = grow();
+            if (m < 0) break;
+            tick();
+            augment(m, limit - state.flow);
+            adopt();
+        }
+        return state.flow;
+    }
+
+private:
+    const FlowTemplate& f_;
+    int s_, t_;
+    uint32_t time_ = 0;
+    vector<uint32_t> ts_;         // time_ at which dist_ was last known to be exact
+    vector<int> dist_;            // tree depth, as of ts_
+    vector<unsigned char> in_active_;
+    deque<int> active_;
+    deque<int> orphans_;
+    vector<int> meets_;           // source -> sink tree edges made by raise()
+    FlowWalker walker_;
+
+    void prepare() {
+        if (ts_.empty()) {
+            ts_.assign(static_cast<size_t>(f_.n), 0);
+            dist_.assign(static_cast<size_t>(f_.n), 0);
+            in_active_.assign(static_cast<size_t>(f_.n), 0);
+        }
+        for (int p : active_) in_active_[static_cast<size_t>(p)] = 0;
+        active_.clear();
+        orphans_.clear();
+        meets_.clear();
+        tick();
+    }
+
+    void tick() {
+        if (++time_ == 0) {
+            std::fill(ts_.begin(), ts_.end(), 0u);
+            time_ = 1;
+        }
+    }
+
+    void activate(int p) {
+        if (in_active_[static_cast<size_t>(p)]) return;
+        in_active_[static_cast<size_t>(p)] = 1;
+        active_.push_back(p);
+    }
+
+    void attach(int q, unsigned char tree, int e, int p) {
+        state.tree[static_cast<size_t>(q)] = tree;
+        state.parent[static_cast<size_t>(q)] = e;
+        ts_[static_cast<size_t>(q)] = ts_[static_cast<size_t>(p)];
+        dist_[static_cast<size_t>(q)] = dist_[static_cast<size_t>(p)] + 1;
+        activate(q);
+    }
+
+    void orphan(int x) {
+        state.parent[static_cast<size_t>(x)] = NONE;
+        orphans_.push_back(x);
+    }
+
+    // Residual capacity of e went up: a tree may grow across it
+    void raised(int e) {
+        int u = f_.to[static_cast<size_t>(e ^ 1)];
+        int w = f_.to[static_cast<size_t>(e)];
+        unsigned char tu = state.tree[static_cast<size_t>(u)];
+        unsigned char tw = state.tree[static_cast<size_t>(w)];
+        if (tu == SOURCE) {
+            if (tw == FREE) attach(w, SOURCE, e ^ 1, u);
+            else if (tw == SINK) meets_.push_back(e);
+        } else if (tw == SINK && tu == FREE) {
+            attach(u, SINK, e, w);
+        }
+    }
+
+    // Residual capacity of e fell to zero: a tree edge across it is lost
+    void lowered(int e) {
+        int u = f_.to[static_cast<size_t>(e ^ 1)];
+        int w = f_.to[static_cast<size_t>(e)];
+        if (state.tree[static_cast<size_t>(w)] == SOURCE && state.parent[static_cast<size_t>(w)] == (e ^ 1)) orphan(w);
+        if (state.tree[static_cast<size_t>(u)] == SINK && state.parent[static_cast<size_t>(u)] == e) orphan(u);
+    }
+
+    // Take one unit of flow off forward edge e
+    void unpush(int e) {
+        state.cap[static_cast<size_t>(e)] = static_cast<Cap>(state.cap[static_cast<size_t>(e)] + 1);
+        state.cap[static_cast<size_t>(e ^ 1)] = static_cast<Cap>(state.cap[static_cast<size_t>(e ^ 1)] - 1);
+        raised(e);
+        if (state.cap[static_cast<size_t>(e ^ 1)] == 0) lowered(e ^ 1);
+    }
+
+    // Grow the trees until they touch; returns the source -> sink edge
+    // where they meet, or -1 once no active node is left
+    int grow() {
+        while (!meets_.empty()) {
+            int m = meets_.back();
+            if (state.cap[static_cast<size_t>(m)] > 0 &&
+                state.tree[static_cast<size_t>(f_.to[static_cast<size_t>(m ^ 1)])] == SOURCE &&
+                state.tree[static_cast<size_t>(f_.to[static_cast<size_t>(m)])] == SINK) {
+                return m;
+            }
+            meets_.pop_back();
+        }
+        while (!active_.empty()) {
+            int p = active_.front();
+            unsigned char tp = state.tree[static_cast<size_t>(p)];
+            if (tp != FREE) {
+                for (int e : f_.edges(p)) {
+                    int q = f_.to[static_cast<size_t>(e)];
+                    unsigned char tq = state.tree[static_cast<size_t>(q)];
+                    if (tp == SOURCE) {
+                        if (state.cap[static_cast<size_t>(e)] <= 0) continue;
+                        if (tq == FREE) attach(q, SOURCE, e ^ 1, p);
+                        else if (tq == SINK) return e;
+                    } else {
+                        if (state.cap[static_cast<size_t>(e ^ 1)] <= 0) continue;
+                        if (tq == FREE) attach(q, SINK, e ^ 1, p);
+                        else if (tq == SOURCE) return e ^ 1;
+                    }
+                }
+            }
+            active_.pop_front();
+            in_active_[static_cast<size_t>(p)] = 0;
+        }
+        return -1;
+    }
+
+    void augment(int m, int room) {
+        const int u = f_.to[static_cast<size_t>(m ^ 1)];
+        const int v = f_.to[static_cast<size_t>(m)];
+        int d = std::min(room, static_cast<int>(state.cap[static_cast<size_t>(m)]));
+        for (int x = u; state.parent[static_cast<size_t>(x)] != ROOT; x = f_.to[static_cast<size_t>(state.parent[static_cast<size_t>(x)])]) {
+            d = std::min(d, static_cast<int>(state.cap[static_cast<size_t>(state.parent[static_cast<size_t>(x)] ^ 1)]));
+        }
+        for (int x = v; state.parent[static_cast<size_t>(x)] != ROOT; x = f_.to[static_cast<size_t>(state.parent[static_cast<size_t>(x)])]) {
+            d = std::min(d, static_cast<int>(state.cap[static_cast<size_t>(state.parent[static_cast<size_t>(x)])]));
+        }
+
+        state.cap[static_cast<size_t>(m)] = static_cast<Cap>(state.cap[static_cast<size_t>(m)] - d);
+        state.cap[static_cast<size_t>(m ^ 1)] = static_cast<Cap>(state.cap[static_cast<size_t>(m ^ 1)] + d);
+        // source side: tree edges run parent -> x, i.e. parent[x] ^ 1
+        for (int x = u; state.parent[static_cast<size_t>(x)] != ROOT;) {
+            int e = state.parent[static_cast<size_t>(x)];
+            int next = f_.to[static_cast<size_t>(e)];
+            state.cap[static_cast<size_t>(e ^ 1)] = static_cast<Cap>(state.cap[static_cast<size_t>(e ^ 1)] - d);
+            state.cap[static_cast<size_t>(e)] = static_cast<Cap>(state.cap[static_cast<size_t>(e)] + d);
+            if (state.cap[static_cast<size_t>(e ^ 1)] == 0) orphan(x);
+            x = next;
+        }
+        // sink side: tree edges run x -> parent
+        for (int x = v; state.parent[static_cast<size_t>(x)] != ROOT;) {
+            int e = state.parent[static_cast<size_t>(x)];
+            int next = f_.to[static_cast<size_t>(e)];
+            state.cap[static_cast<size_t>(e)] = static_cast<Cap>(state.cap[static_cast<size_t>(e)] - d);
+            state.cap[static_cast<size_t>(e ^ 1)] = static_cast<Cap>(state.cap[static_cast<size_t>(e ^ 1)] + d);
+            if (state.cap[static_cast<size_t>(e)] == 0) orphan(x);
+            x = next;
+        }
+        state.flow += d;
+    }
+
+    // Tree depth of q if it still hangs from a terminal (INT32_MAX if not),
+    // stamping the path walked so later checks stop early
+    int origin_distance(int q) {
+        int d = 0;
+        int j = q;
+        for (;;) {
+            if (ts_[static_cast<size_t>(j)] == time_) {
+                d += dist_[static_cast<size_t>(j)];
+                break;
+            }
+            int e = state.parent[static_cast<size_t>(j)];
+            if (e == ROOT) {
+                ts_[static_cast<size_t>(j)] = time_;
+                dist_[static_cast<size_t>(j)] = 0;
+                break;
+            }
+            if (e == NONE) return INT32_MAX;
+            d++;
+            j = f_.to[static_cast<size_t>(e)];
+        }
+        int dd = d;
+        for (j = q; ts_[static_cast<size_t>(j)] != time_; j = f_.to[static_cast<size_t>(state.parent[static_cast<size_t>(j)])]) {
+            ts_[static_cast<size_t>(j)] = time_;
+            dist_[static_cast<size_t>(j)] = dd--;
+        }
+        return d;
+    }
+
+    // Re-attach each orphan to the closest rooted neighbour in its tree, or
+    // free it (orphaning its children and waking neighbours that can grow
+    // into it)
+    void adopt() {
+        while (!orphans_.empty()) {
+            int p = orphans_.front();
+            orphans_.pop_front();
+            unsigned char tp = state.tree[static_cast<size_t>(p)];
+            int best = NONE;
+            int dmin = INT32_MAX;
+            for (int e : f_.edges(p)) {
+                int q = f_.to[static_cast<size_t>(e)];
+                if (state.tree[static_cast<size_t>(q)] != tp) continue;
+                if ((tp == SOURCE ? state.cap[static_cast<size_t>(e ^ 1)] : state.cap[static_cast<size_t>(e)]) <= 0) continue;
+                int d = origin_distance(q);
+                if (d < dmin) {
+                    best = e;
+                    dmin = d;
+                }
+            }
+            if (best != NONE) {
+                state.parent[static_cast<size_t>(p)] = best;
+                ts_[static_cast<size_t>(p)] = time_;
+                dist_[static_cast<size_t>(p)] = dmin + 1;
+                continue;
+            }
+            for (int e : f_.edges(p)) {
+                int q = f_.to[static_cast<size_t>(e)];
+                unsigned char tq = state.tree[static_cast<size_t>(q)];
+                if (tq == FREE) continue;
+                if ((tq == SOURCE ? state.cap[static_cast<size_t>(e ^ 1)] : state.cap[static_cast<size_t>(e)]) > 0) activate(q);
+                int pq = state.parent[static_cast<size_t>(q)];
+                if (tq == tp && pq >= 0 && f_.to[static_cast<size_t>(pq)] == p) orphan(q);
+            }
+            state.tree[static_cast<size_t>(p)] = FREE;
+        }
+    }
+};
+
+/* ---------------- Push-Relabel ---------------- */
+
+// Highest-label push-relabel with global relabeling and the gap heuristic,
+// with the same contract as FlowTemplate::maxflow_limit: cap is left as the
+// residual of a flow of value min(max flow, limit). The source starts with
+// `limit` units of excess instead of saturating its edges, so a query that
+// fails stops as soon as `limit` units reach the sink. Starting heights
+// come from a BFS out of the source that stops at the sink: with D the
+// sink's distance, h = D - distance is a valid labelling and only touches
+// the cells between the two. A full BFS back from the sink (global relabel)
+// runs when relabelling work piles up, and once more when the run stops
+// below the limit. After that, sink_side(v) says whether v reaches the sink
+// in the residual graph. Edges must be added with zero reverse capacity
+// (see FlowWalker).
+template <class Cap>
+class PushRelabel {
+public:
+    explicit PushRelabel(const FlowTemplate& f) : f_(f), n_(f.n), walker_(f) {}
+
+    int maxflow_limit(int s, int t, vector<Cap>& cap, int limit) {
+        if (height_.empty()) {
+            height_.assign(static_cast<size_t>(n_), 0);
+            excess_.assign(static_cast<size_t>(n_), 0);
+            cur_.assign(static_cast<size_t>(n_), 0);
+            next_.assign(static_cast<size_t>(n_), -1);
+            prev_.assign(static_cast<size_t>(n_), -1);
+            anext_.assign(static_cast<size_t>(n_), -1);
+            first_.assign(static_cast<size_t>(n_) + 1, -1);
+            afirst_.assign(static_cast<size_t>(n_) + 1, -1);
+            queue_.resize(static_cast<size_t>(n_));
+            seen_.assign(static_cast<size_t>(n_), 0);
+        }
+        cap_ = &cap;
+        t_ = t;
+        if (++stamp_ == 0) {
+            std::fill(seen_.begin(), seen_.end(), 0u);
+            stamp_ = 1;
+        }
+        touched_.clear();
+
+        excess_[static_cast<size_t>(s)] = limit;
+        if (seed_heights(s)) {
+            activate(s);
+            while (excess_[static_cast<size_t>(t)] < limit) {
+                while (top_ >= 0 && afirst_[static_cast<size_t>(top_)] < 0) top_--;
+                if (top_ < 0) break;
+                int u = afirst_[static_cast<size_t>(top_)];
+                afirst_[static_cast<size_t>(top_)] = anext_[static_cast<size_t>(u)];
+                // entries go stale when a gap lifts their node
+                if (height_[static_cast<size_t>(u)] != top_ || excess_[static_cast<size_t>(u)] <= 0) continue;
+                discharge(u);
+                if (work_ > period_) global_relabel();
+            }
+        }
+
+        int flow = excess_[static_cast<size_t>(t)];
+        if (flow < limit) {
+            global_relabel();
+            // Return stranded excess to s so cap holds a flow again; none
+            // of it can reach t, so the sink side is unchanged
+            auto unpush = [&](int e, int d) {
+                cap[static_cast<size_t>(e)] = static_cast<Cap>(cap[static_cast<size_t>(e)] + d);
+                cap[static_cast<size_t>(e ^ 1)] = static_cast<Cap>(cap[static_cast<size_t>(e ^ 1)] - d);
+            };
+            // each walk empties an edge or the excess, so the work is
+            // bounded by the edges, not by limit - flow units
+            for (int x : touched_) {
+                if (x == s || x == t) continue;
+                int& ex = excess_[static_cast<size_t>(x)];
+                while (ex > 0) ex -= walker_.cancel_up_to(cap, x, true, s, ex, unpush);
+            }
+        }
+        excess_[static_cast<size_t>(s)] = 0;
+        excess_[static_cast<size_t>(t)] = 0;
+        return flow;
+    }
+
+    // After a run that stopped below its limit
+    bool sink_side(int v) const { return height_[static_cast<size_t>(v)] < n_; }
+
+private:
+    const FlowTemplate& f_;
+    int n_;
+    int t_ = 0;
+    vector<Cap>* cap_ = nullptr;
+    vector<int> height_;            // n_ once v cannot reach t
+    vector<int> excess_;            // zero everywhere between runs
+    vector<int> cur_;               // current arc, as an offset into adj_list
+    vector<int> next_, prev_;       // nodes of each height 1 .. n_ - 1, for the gap heuristic
+    vector<int> first_;
+    vector<int> anext_, afirst_;    // nodes with excess, by height
+    vector<int> queue_;
+    vector<uint32_t> seen_;         // stamp_ once cur_ is set this run
+    vector<int> touched_;           // nodes given excess this run
+    uint32_t stamp_ = 0;
+    int top_ = -1;                  // highest height that may hold an active node
+    int max_height_ = 0;            // highest listed height since the lists were cleared
+    size_t work_ = 0;
+    size_t period_ = 0;             // relabel work between global relabels
+    FlowWalker walker_;
+
+    void clear_lists() {
+        std::fill(first_.begin(), first_.begin() + max_height_ + 1, -1);
+        std::fill(afirst_.begin(), afirst_.begin() + max_height_ + 1, -1);
+        top_ = -1;
+        max_height_ = 0;
+    }
+
+    // Level 0 (the sink and anything not yet labelled) is never listed: it
+    // cannot empty, and a gap above it only concerns listed nodes
+    void link(int v, int h) {
+        height_[static_cast<size_t>(v)] = h;
+        if (h <= 0 || h >= n_) return;
+        if (h > max_height_) max_height_ = h;
+        prev_[static_cast<size_t>(v)] = -1;
+        next_[static_cast<size_t>(v)] = first_[static_cast<size_t>(h)];
+        if (first_[static_cast<size_t>(h)] >= 0) prev_[static_cast<size_t>(first_[static_cast<size_t>(h)])] = v;
+        first_[static_cast<size_t>(h)] = v;
+    }
+
+    void unlink(int v) {
+        int h = height_[static_cast<size_t>(v)];
+        if (h <= 0 || h >= n_) return;
+        int p = prev_[static_cast<size_t>(v)];
+        int nx = next_[static_cast<size_t>(v)];
+        if (p >= 0) next_[static_cast<size_t>(p)] = nx;
+        else first_[static_cast<size_t>(h)] = nx;
+        if (nx >= 0) prev_[static_cast<size_t>(nx)] = p;
+    }
+
+    void visit(int v) {
+        if (seen_[static_cast<size_t>(v)] == stamp_) return;
+        seen_[static_cast<size_t>(v)] = stamp_;
+        cur_[static_cast<size_t>(v)] = f_.adj_start[static_cast<size_t>(v)];
+    }
+
+    void activate(int v) {
+        visit(v);
+        touched_.push_back(v);
+        int h = height_[static_cast<size_t>(v)];
+        if (h > max_height_) max_height_ = h;
+        anext_[static_cast<size_t>(v)] = afirst_[static_cast<size_t>(h)];
+        afirst_[static_cast<size_t>(h)] = v;
+        if (h > top_) top_ = h;
+    }
+
+    // Heights D - dist(s, v) from a BFS out of s that stops on reaching t.
+    // Everything else stays at 0. False if t is unreachable.
+    bool seed_heights(int s) {
+        const vector<Cap>& cap = *cap_;
+        std::fill(height_.begin(), height_.end(), 0);
+        clear_lists();
+        size_t head = 0, tail = 0;
+        visit(s);
+        queue_[tail++] = s;
+        int d_t = -1;
+        while (head < tail && d_t < 0) {
+            int u = queue_[head++];
+            int du = height_[static_cast<size_t>(u)];
+            for (int e : f_.edges(u)) {
+                if (cap[static_cast<size_t>(e)] <= 0) continue;
+                int v = f_.to[static_cast<size_t>(e)];
+                if (v == t_) {
+                    d_t = du + 1;
+                    break;
+                }
+                if (seen_[static_cast<size_t>(v)] == stamp_) continue;
+                visit(v);
+                height_[static_cast<size_t>(v)] = du + 1;
+                queue_[tail++] = v;
+            }
+        }
+        for (size_t i = 0; i < tail; i++) {
+            int v = queue_[i];
+            int d = height_[static_cast<size_t>(v)];
+            height_[static_cast<size_t>(v)] = 0;
+            if (d_t > d) link(v, d_t - d);
+        }
+        height_[static_cast<size_t>(t_)] = 0;
+        work_ = 0;
+        period_ = 12 * tail + 64;
+        return d_t > 0;
+    }
+
+    // Exact heights by a BFS back from t over residual edges
+    void global_relabel() {
+        const vector<Cap>& cap = *cap_;
+        std::fill(height_.begin(), height_.end(), n_);
+        clear_lists();
+
+        size_t head = 0, tail = 0;
+        link(t_, 0);
+        queue_[tail++] = t_;
+        while (head < tail) {
+            int v = queue_[head++];
+            int hv = height_[static_cast<size_t>(v)];
+            // e leaves v, so e ^ 1 is the residual edge u -> v
+            for (int e : f_.edges(v)) {
+                int u = f_.to[static_cast<size_t>(e)];
+                if (cap[static_cast<size_t>(e ^ 1)] > 0 && height_[static_cast<size_t>(u)] == n_) {
+                    link(u, hv + 1);
+                    queue_[tail++] = u;
+                }
+            }
+        }
+        // every node left with excess and a height is queued exactly once
+        for (size_t i = 0; i < tail; i++) {
+            int v = queue_[i];
+            seen_[static_cast<size_t>(v)] = stamp_;
+            cur_[static_cast<size_t>(v)] = f_.adj_start[static_cast<size_t>(v)];
+            if (v != t_ && excess_[static_cast<size_t>(v)] > 0) {
+                int h = height_[static_cast<size_t>(v)];
+                anext_[static_cast<size_t>(v)] = afirst_[static_cast<size_t>(h)];
+                afirst_[static_cast<size_t>(h)] = v;
+                top_ = std::max(top_, h);
+            }
+        }
+        work_ = 0;
+        period_ = 12 * tail + 64;
+    }
+
+    // Push u's excess down admissible edges, relabelling when none is left
+    void discharge(int u) {
+        vector<Cap>& cap = *cap_;
+        const int end = f_.adj_start[static_cast<size_t>(u) + 1];
+        while (excess_[static_cast<size_t>(u)] > 0) {
+            int hu = height_[static_cast<size_t>(u)];
+            for (int& i = cur_[static_cast<size_t>(u)]; i < end; i++) {
+                int e = f_.adj_list[static_cast<size_t>(i)];
+                int v = f_.to[static_cast<size_t>(e)];
+                if (cap[static_cast<size_t>(e)] <= 0 || height_[static_cast<size_t>(v)] != hu - 1) continue;
+                int d = std::min(excess_[static_cast<size_t>(u)], static_cast<int>(cap[static_cast<size_t>(e)]));
+                cap[static_cast<size_t>(e)] = static_cast<Cap>(cap[static_cast<size_t>(e)] - d);
+                cap[static_cast<size_t>(e ^ 1)] = static_cast<Cap>(cap[static_cast<size_t>(e ^ 1)] + d);
+                if (excess_[static_cast<size_t>(v)] == 0 && v != t_) activate(v);
+                excess_[static_cast<size_t>(v)] += d;
+                excess_[static_cast<size_t>(u)] -= d;
+                if (excess_[static_cast<size_t>(u)] == 0) return;
+            }
+            relabel(u);
+            if (height_[static_cast<size_t>(u)] >= n_) return;
+        }
+    }
+
+    void relabel(int u) {
+        const vector<Cap>& cap = *cap_;
+        int old = height_[static_cast<size_t>(u)];
+        unlink(u);
+        if (old > 0 && first_[static_cast<size_t>(old)] < 0) {
+            // gap: nothing at `old` is left, so nothing above it reaches t
+            height_[static_cast<size_t>(u)] = n_;
+            for (int h = old + 1; h <= max_height_; h++) {
+                for (int v = first_[static_cast<size_t>(h)]; v >= 0; v = next_[static_cast<size_t>(v)]) {
+                    height_[static_cast<size_t>(v)] = n_;
+                }
+                first_[static_cast<size_t>(h)] = -1;
+            }
+            return;
+        }
+        int h = n_;
+        IdRange es = f_.edges(u);
+        for (int e : es) {
+            if (cap[static_cast<size_t>(e)] > 0) h = std::min(h, height_[static_cast<size_t>(f_.to[static_cast<size_t>(e)])] + 1);
+        }
+        work_ += es.size() + 12;
+        cur_[static_cast<size_t>(u)] = f_.adj_start[static_cast<size_t>(u)];
+        link(u, h);
+    }
+};
+
+/* ---------------- Packed Grid ---------------- */
+
+enum : unsigned { CELL_BLOCKED = 0, CELL_EMPTY = 1, CELL_HORSE = 2 };
+
+// Read-only board at 2 bits per cell (row-major, 32 cells per little-endian
+// uint64_t word). Points into a PackedGrid or straight into a mapped corpus
+// file; the solver reads boards only through this.
+struct PackedGridView {
+    int R = 0, C = 0;
+    const uint64_t* bits = nullptr;
+
+    unsigned at(int r, int c) const {
+        size_t i = static_cast<size_t>(r) * static_cast<size_t>(C) + static_cast<size_t>(c);
+        return static_cast<unsigned>((bits[i >> 5] >> ((i & 31) * 2)) & 3ULL);
+    }
+
+    static size_t word_count(int R, int C) {
+        return (static_cast<size_t>(R) * static_cast<size_t>(C) + 31) / 32;
+    }
+
+    // Back to text; every blocked cell becomes '#'
+    vector<string> to_rows() const {
+        static const char sym[4] = {'#', '.', 'H', '#'};
+        vector<string> rows(static_cast<size_t>(R), string(static_cast<size_t>(C), '#'));
+        for (int r = 0; r < R; r++) {
+            for (int c = 0; c < C; c++) rows[static_cast<size_t>(r)][static_cast<size_t>(c)] = sym[at(r, c)];
+        }
+        return rows;
+    }
+};
+
+// Owning packed board, a quarter of a vector<string>. Rows are appended one
+// at a time, so large boards can be streamed in without holding the text.
+// The first row fixes the width: shorter rows are padded with blocked cells
+// and longer ones cut.
+struct PackedGrid {
+    int R = 0, C = 0;
+    vector<uint64_t> bits;
+
+    static PackedGrid from_rows(const vector<string>& rows) {
+        PackedGrid pg;
+        if (!rows.empty()) pg.bits.reserve(PackedGridView::word_count(static_cast<int>(rows.size()), static_cast<int>(rows[0].size())));
+        for (const auto& row : rows) pg.push_row(row);
+        return pg;
+    }
+
+    void push_row(const string& row) {
+        if (R == 0) C = static_cast<int>(row.size());
+        size_t base = static_cast<size_t>(R) * static_cast<size_t>(C);
+        bits.resize(PackedGridView::word_count(R + 1, C), 0ULL);
+        size_t n = std::min(row.size(), static_cast<size_t>(C));
+        for (size_t c = 0; c < n; c++) {
+            uint64_t v = row[c] == '.' ? CELL_EMPTY : row[c] == 'H' ? CELL_HORSE : CELL_BLOCKED;
+            size_t i = base + c;
+            bits[i >> 5] |= v << ((i & 31) * 2);
+        }
+        R++;
+    }
+
+    PackedGridView view() const { return {R, C, bits.data()}; }
+};
+
+/* ---------------- Cell Graph ---------------- */
 
 inline bool is_open_cell(char ch) {
     return ch == '.' || ch == 'H';
 }
 
-inline SolveResult solve(int k, const vector<string>& grid) {
-    int R = static_cast<int>(grid.size());
-    int C = static_cast<int>(grid[0].size());
+// How cell ids are assigned. Spatial orders keep neighbouring cells close in
+// adj, the flow arrays and bitset words.
+enum class CellOrder {
+    Bfs,        // discovery order from the horse
+    RowMajor,
+    Morton,     // Z-order curve
+    Hilbert,
+};
+
+inline bool parse_cell_order(const string& s, CellOrder& out) {
+    if (s == "bfs") out = CellOrder::Bfs;
+    else if (s == "row-major") out = CellOrder::RowMajor;
+    else if (s == "morton") out = CellOrder::Morton;
+    else if (s == "hilbert") out = CellOrder::Hilbert;
+    else return false;
+    return true;
+}
+
+// Position of (r, c) along the Z-order curve
+inline uint64_t morton_index(int r, int c) {
+    auto spread = [](uint64_t x) {
+        x &= 0xffffffffULL;
+        x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        x = (x | (x << 2)) & 0x3333333333333333ULL;
+        x = (x | (x << 1)) & 0x5555555555555555ULL;
+        return x;
+    };
+    return (spread(static_cast<uint64_t>(r)) << 1) | spread(static_cast<uint64_t>(c));
+}
+
+// Position of (r, c) along the Hilbert curve filling a side x side square
+// (side a power of two)
+inline uint64_t hilbert_index(int r, int c, int side) {
+    uint64_t d = 0;
+    for (int s = side / 2; s > 0; s /= 2) {
+        int rx = (c & s) ? 1 : 0;
+        int ry = (r & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * static_cast<uint64_t>(s) * static_cast<uint64_t>((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                c = side - 1 - c;
+                r = side - 1 - r;
+            }
+            std::swap(r, c);
+        }
+    }
+    return d;
+}
+
+// Open cells reachable from the horse, numbered in the requested CellOrder.
+// Adjacency is CSR: the neighbours of i are adj_list[adj_start[i] .. adj_start[i+1]).
+struct CellGraph {
+    int R = 0, C = 0, N = 0;
+    int horse_idx = 0;
+    vector<pair<int,int>> coords;
+    vector<int> adj_start;
+    vector<int> adj_list;
+    vector<unsigned char> wallable;
+    DynamicBitset boundary;
+
+    IdRange neighbors(int i) const {
+        return {adj_list.data() + adj_start[static_cast<size_t>(i)], adj_list.data() + adj_start[static_cast<size_t>(i) + 1]};
+    }
+
+    // Cells reachable from the horse when `blocked` cells are walls
+    void reachable(const DynamicBitset& blocked,
+                   DynamicBitset& vis_out,
+                   int& area_out,
+                   bool& escapes_out) const {
+        vis_out.init(N);
+        if (blocked.test(horse_idx)) {
+            area_out = 0;
+            escapes_out = true;
+            return;
+        }
+        deque<int> dq;
+        dq.push_back(horse_idx);
+        vis_out.set(horse_idx);
+
+        while (!dq.empty()) {
+            int u = dq.front();
+            dq.pop_front();
+            for (int v : neighbors(u)) {
+                if (blocked.test(v)) continue;
+                if (vis_out.test(v)) continue;
+                vis_out.set(v);
+                dq.push_back(v);
+            }
+        }
+        area_out = vis_out.popcount();
+        escapes_out = vis_out.intersects(boundary);
+    }
+};
+
+inline CellGraph build_cell_graph(const PackedGridView& grid, CellOrder order = CellOrder::Bfs) {
+    CellGraph g;
+    int R = grid.R;
+    int C = grid.C;
+    g.R = R;
+    g.C = C;
 
     int hr = -1, hc = -1;
     for (int r = 0; r < R && hr == -1; r++) {
         for (int c = 0; c < C; c++) {
-            if (grid[static_cast<size_t>(r)][static_cast<size_t>(c)] == 'H') {
+            if (grid.at(r, c) == CELL_HORSE) {
                 hr = r; hc = c; break;
             }
         }
     }
     if (hr == -1) throw std::runtime_error("grid に 'H' が見つかりません");
 
-    unordered_map<long long, int> idx_of;
-    idx_of.reserve(static_cast<size_t>(R) * 4);
-
-    auto key = [&](int r, int c) -> long long {
-        return (static_cast<long long>(r) << 32) ^ static_cast<unsigned long long>(c);
+    // Flat R*C map from grid position to cell id (-1: not a reachable open cell)
+    vector<int> idx_of(static_cast<size_t>(R) * static_cast<size_t>(C), -1);
+    auto pos = [&](int r, int c) -> size_t {
+        return static_cast<size_t>(r) * static_cast<size_t>(C) + static_cast<size_t>(c);
     };
 
-    vector<pair<int,int>> coords;
+    vector<pair<int,int>>& coords = g.coords;
     coords.reserve(1024);
 
-    idx_of[key(hr, hc)] = 0;
+    // coords doubles as the BFS queue: cells are appended in discovery order
+    idx_of[pos(hr, hc)] = 0;
     coords.push_back({hr, hc});
-    deque<pair<int,int>> q;
-    q.push_back({hr, hc});
 
     const int drs[4] = {1, -1, 0, 0};
     const int dcs[4] = {0, 0, 1, -1};
 
-    while (!q.empty()) {
-        pair<int,int> cur = q.front();
-        q.pop_front();
-        int r = cur.first, c = cur.second;
+    for (size_t head = 0; head < coords.size(); head++) {
+        int r = coords[head].first, c = coords[head].second;
 
         for (int di = 0; di < 4; di++) {
             int nr = r + drs[di], nc = c + dcs[di];
             if (nr < 0 || nr >= R || nc < 0 || nc >= C) continue;
-            if (!is_open_cell(grid[static_cast<size_t>(nr)][static_cast<size_t>(nc)])) continue;
+            if (grid.at(nr, nc) == CELL_BLOCKED) continue;
 
-            long long kk = key(nr, nc);
-            if (idx_of.find(kk) != idx_of.end()) continue;
-
-            int id = static_cast<int>(coords.size());
-            idx_of[kk] = id;
+            int& id = idx_of[pos(nr, nc)];
+            if (id >= 0) continue;
+            id = static_cast<int>(coords.size());
             coords.push_back({nr, nc});
-            q.push_back({nr, nc});
         }
     }
+    coords.shrink_to_fit();
 
     int N = static_cast<int>(coords.size());
-    int horse_idx = 0;
+    g.N = N;
+    g.horse_idx = 0;
+
+    if (order != CellOrder::Bfs) {
+        int side = 1;
+        while (side < R || side < C) side *= 2;
+        vector<pair<uint64_t, pair<int,int>>> keyed;
+        keyed.reserve(static_cast<size_t>(N));
+        for (const auto& rc : coords) {
+            uint64_t k = order == CellOrder::RowMajor ? pos(rc.first, rc.second)
+                       : order == CellOrder::Morton   ? morton_index(rc.first, rc.second)
+                                                      : hilbert_index(rc.first, rc.second, side);
+            keyed.push_back({k, rc});
+        }
+        std::sort(keyed.begin(), keyed.end());
+        for (int i = 0; i < N; i++) {
+            coords[static_cast<size_t>(i)] = keyed[static_cast<size_t>(i)].second;
+            idx_of[pos(coords[static_cast<size_t>(i)].first, coords[static_cast<size_t>(i)].second)] = i;
+        }
+        g.horse_idx = idx_of[pos(hr, hc)];
+    }
 
-    vector<vector<int>> adj(static_cast<size_t>(N));
-    vector<unsigned char> wallable(static_cast<size_t>(N), 0);
-    DynamicBitset boundary(N);
+    g.adj_start.assign(static_cast<size_t>(N) + 1, 0);
+    g.adj_list.reserve(4 * static_cast<size_t>(N));
+    g.wallable.assign(static_cast<size_t>(N), 0);
+    g.boundary.init(N);
 
     for (int i = 0; i < N; i++) {
         int r = coords[static_cast<size_t>(i)].first;
         int c = coords[static_cast<size_t>(i)].second;
 
-        if (r == 0 || r == R - 1 || c == 0 || c == C - 1) boundary.set(i);
-        wallable[static_cast<size_t>(i)] = (grid[static_cast<size_t>(r)][static_cast<size_t>(c)] == '.');
+        if (r == 0 || r == R - 1 || c == 0 || c == C - 1) g.boundary.set(i);
+        g.wallable[static_cast<size_t>(i)] = (grid.at(r, c) == CELL_EMPTY);
 
         for (int di = 0; di < 4; di++) {
             int nr = r + drs[di], nc = c + dcs[di];
-            long long kk = key(nr, nc);
-            auto it = idx_of.find(kk);
-            if (it != idx_of.end()) adj[static_cast<size_t>(i)].push_back(it->second);
+            if (nr < 0 || nr >= R || nc < 0 || nc >= C) continue;
+            int j = idx_of[pos(nr, nc)];
+            if (j >= 0) g.adj_list.push_back(j);
         }
+        g.adj_start[static_cast<size_t>(i) + 1] = static_cast<int>(g.adj_list.size());
     }
+    return g;
+}
+
+inline CellGraph build_cell_graph(const vector<string>& grid, CellOrder order = CellOrder::Bfs) {
+    return build_cell_graph(PackedGrid::from_rows(grid).view(), order);
+}
 
-    if (boundary.test(horse_idx)) {
-        return {0, {}};
+/* ---------------- Reachability Tracker ---------------- */
+
+// Region reachable from the horse as walls are added one at a time along a
+// DFS path, with undo. block(v) removes only what v cuts off: it searches
+// outward from v's neighbours in lock-step and stops once every side but the
+// horse's is known, so the cost follows the cut-off parts rather than the
+// whole region. undo() puts back the cells the last block() removed.
+class ReachTracker {
+public:
+    explicit ReachTracker(const CellGraph& g)
+        : g_(g), seen_(static_cast<size_t>(g.N), 0), owner_(static_cast<size_t>(g.N), 0) {}
+
+    // Full BFS for a fresh wall set; clears the undo log
+    void reset(const DynamicBitset& blocked) {
+        bool esc = false;
+        g_.reachable(blocked, reach_, area_, esc);
+        boundary_cells_ = (reach_ & g_.boundary).popcount();
+        removed_.clear();
+        marks_.clear();
     }
 
-    const int INF = k + 1;
-    int node_count = 2 * N + 2;
-    int SRC = 2 * N;
-    int SNK = 2 * N + 1;
+    void block(int v) {
+        marks_.push_back(removed_.size());
+        if (!reach_.test(v)) return;
+        if (v == g_.horse_idx) {
+            reach_.for_each_set_bit([&](int u) { removed_.push_back(u); });
+            for (size_t i = marks_.back(); i < removed_.size(); i++) remove(removed_[i]);
+            return;
+        }
+        remove(v);
+        removed_.push_back(v);
+
+        // One search per neighbour still in the region; searches that meet
+        // are merged. Every side of v holds one of these neighbours.
+        int m = 0;
+        for (int u : g_.neighbors(v)) {
+            if (!reach_.test(u)) continue;
+            queue_[m].clear();
+            head_[m] = 0;
+            parent_[m] = m;
+            horse_[m] = false;
+            m++;
+        }
+        if (m <= 1) return;
 
-    FlowTemplate flow(node_count);
-    vector<int> cell_edge_idx(static_cast<size_t>(N));
-    vector<int> src_edge_idx(static_cast<size_t>(N));
+        if (++stamp_ == 0) {
+            std::fill(seen_.begin(), seen_.end(), 0u);
+            stamp_ = 1;
+        }
+        m = 0;
+        for (int u : g_.neighbors(v)) {
+            if (!reach_.test(u)) continue;
+            visit(u, m);
+            m++;
+        }
 
-    for (int i = 0; i < N; i++) {
-        int cap_cell = (i == horse_idx || !wallable[static_cast<size_t>(i)]) ? INF : 1;
-        cell_edge_idx[static_cast<size_t>(i)] = flow.add_edge(2 * i, 2 * i + 1, cap_cell);
+        while (true) {
+            // Sides are whole once their queues run dry; the horse's side
+            // needs no further expansion
+            int open = 0, open_root = -1;
+            bool horse_found = false;
+            for (int s = 0; s < m; s++) {
+                if (find(s) != s) continue;
+                if (horse_[s]) { horse_found = true; continue; }
+                if (!group_done(s, m)) { open++; open_root = s; }
+            }
+            if (open == 0 || (!horse_found && open == 1)) {
+                int keep = horse_found ? -1 : open_root;
+                for (int s = 0; s < m; s++) {
+                    int root = find(s);
+                    if (horse_[root] || root == keep) continue;
+                    for (int u : queue_[s]) {
+                        remove(u);
+                        removed_.push_back(u);
+                    }
+                }
+                return;
+            }
+            for (int s = 0; s < m; s++) {
+                if (head_[s] >= queue_[s].size() || horse_[find(s)]) continue;
+                int u = queue_[s][head_[s]++];
+                for (int w : g_.neighbors(u)) {
+                    if (!reach_.test(w)) continue;
+                    if (seen_[static_cast<size_t>(w)] == stamp_) {
+                        unite(s, owner_[static_cast<size_t>(w)]);
+                        continue;
+                    }
+                    visit(w, s);
+                }
+            }
+        }
     }
 
-    for (int i = 0; i < N; i++) {
-        int out_i = 2 * i + 1;
-        for (int j : adj[static_cast<size_t>(i)]) {
-            flow.add_edge(out_i, 2 * j, INF);
+    void undo() {
+        size_t mark = marks_.back();
+        marks_.pop_back();
+        for (size_t i = mark; i < removed_.size(); i++) {
+            int u = removed_[i];
+            reach_.set(u);
+            area_++;
+            if (g_.boundary.test(u)) boundary_cells_++;
         }
+        removed_.resize(mark);
     }
 
-    for (int i = 0; i < N; i++) {
-        if (boundary.test(i)) {
-            flow.add_edge(2 * i + 1, SNK, INF);
+    const DynamicBitset& region() const { return reach_; }
+    int area() const { return area_; }
+    bool escapes() const { return boundary_cells_ > 0; }
+
+    // Area of what stays joined to the horse if `walls` are blocked as
+    // well, or -1 if that part reaches the boundary. The search never
+    // leaves the current region, so it costs the answer, not the board.
+    int area_without(const DynamicBitset& walls) {
+        if (!reach_.test(g_.horse_idx) || walls.test(g_.horse_idx)) return -1;
+        if (++stamp_ == 0) {
+            std::fill(seen_.begin(), seen_.end(), 0u);
+            stamp_ = 1;
         }
+        vector<int>& q = queue_[0];
+        q.clear();
+        q.push_back(g_.horse_idx);
+        seen_[static_cast<size_t>(g_.horse_idx)] = stamp_;
+        for (size_t head = 0; head < q.size(); head++) {
+            int u = q[head];
+            if (g_.boundary.test(u)) return -1;
+            for (int w : g_.neighbors(u)) {
+                if (!reach_.test(w) || walls.test(w) || seen_[static_cast<size_t>(w)] == stamp_) continue;
+                seen_[static_cast<size_t>(w)] = stamp_;
+                q.push_back(w);
+            }
+        }
+        return static_cast<int>(q.size());
     }
 
-    for (int i = 0; i < N; i++) {
-        int cap_src = (i == horse_idx) ? INF : 0;
-        src_edge_idx[static_cast<size_t>(i)] = flow.add_edge(SRC, 2 * i + 1, cap_src);
+private:
+    const CellGraph& g_;
+    DynamicBitset reach_;
+    int area_ = 0;
+    int boundary_cells_ = 0;
+    vector<int> removed_;        // cells taken out, grouped by block()
+    vector<size_t> marks_;       // removed_.size() at each block()
+
+    // block() scratch: per-search queues (also the visited lists), merged
+    // searches via a tiny union-find; area_without() borrows queue_[0]
+    vector<unsigned> seen_;      // == stamp_ if visited by the current block()
+    vector<int> owner_;
+    unsigned stamp_ = 0;
+    vector<int> queue_[4];
+    size_t head_[4] = {};
+    int parent_[4] = {};
+    bool horse_[4] = {};
+
+    void remove(int u) {
+        reach_.reset(u);
+        area_--;
+        if (g_.boundary.test(u)) boundary_cells_--;
     }
 
-    const vector<int> base_cap = flow.base_cap;
+    void visit(int u, int s) {
+        seen_[static_cast<size_t>(u)] = stamp_;
+        owner_[static_cast<size_t>(u)] = s;
+        queue_[s].push_back(u);
+        if (u == g_.horse_idx) horse_[find(s)] = true;
+    }
 
-    auto bfs_reachable = [&](const DynamicBitset& blocked,
-                             DynamicBitset& vis_out,
-                             int& area_out,
-                             bool& escapes_out) {
-        vis_out.init(N);
-        if (blocked.test(horse_idx)) {
-            area_out = 0;
-            escapes_out = true;
-            return;
+    int find(int s) {
+        while (parent_[s] != s) s = parent_[s];
+        return s;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        parent_[b] = a;
+        horse_[a] = horse_[a] || horse_[b];
+    }
+
+    bool group_done(int root, int m) {
+        for (int s = 0; s < m; s++) {
+            if (find(s) == root && head_[s] < queue_[s].size()) return false;
         }
-        deque<int> dq;
-        dq.push_back(horse_idx);
-        vis_out.set(horse_idx);
+        return true;
+    }
+};
 
-        while (!dq.empty()) {
-            int u = dq.front();
-            dq.pop_front();
-            for (int v : adj[static_cast<size_t>(u)]) {
-                if (blocked.test(v)) continue;
-                if (vis_out.test(v)) continue;
-                vis_out.set(v);
-                dq.push_back(v);
+/* ---------------- Separator Network ---------------- */
+
+// Split-vertex flow network for a cell graph: cell i is in-node 2i and
+// out-node 2i+1 joined by a capacity-1 edge if wallable (INF otherwise).
+// SRC feeds the horse (and forced cells), boundary cells drain to SNK.
+// Residual capacities never exceed INF = k+1, so Cap can be as narrow as
+// the budget allows: solve() uses int8_t below k = 127.
+template <class Cap = int>
+struct SeparatorNetwork {
+    int N = 0;
+    int INF = 0;
+    int node_count = 0;
+    int SRC = 0, SNK = 0;
+    FlowTemplate flow;
+    vector<int> cell_edge_idx;
+    vector<int> src_edge_idx;
+    vector<Cap> base_cap;
+
+    SeparatorNetwork(const CellGraph& g, int k)
+        : N(g.N), INF(k + 1), node_count(2 * g.N + 2), SRC(2 * g.N), SNK(2 * g.N + 1),
+          flow(2 * g.N + 2), cell_edge_idx(static_cast<size_t>(g.N)), src_edge_idx(static_cast<size_t>(g.N)) {
+        size_t edges = 2 * static_cast<size_t>(N) + g.adj_list.size() + static_cast<size_t>(g.boundary.popcount());
+        flow.reserve_edges(edges);
+        base_cap.reserve(2 * edges);
+
+        for (int i = 0; i < N; i++) {
+            int cap_cell = (i == g.horse_idx || !g.wallable[static_cast<size_t>(i)]) ? INF : 1;
+            cell_edge_idx[static_cast<size_t>(i)] = add_edge(2 * i, 2 * i + 1, cap_cell);
+        }
+
+        for (int i = 0; i < N; i++) {
+            int out_i = 2 * i + 1;
+            for (int j : g.neighbors(i)) {
+                add_edge(out_i, 2 * j, INF);
             }
         }
-        area_out = vis_out.popcount();
-        escapes_out = vis_out.intersects(boundary);
-    };
 
-    auto min_separator = [&](const DynamicBitset& deleted,
-                             const DynamicBitset& forced,
-                             int k_rem,
-                             DynamicBitset& sep_out) -> bool {
-        vector<int> cap = base_cap;
+        for (int i = 0; i < N; i++) {
+            if (g.boundary.test(i)) {
+                add_edge(2 * i + 1, SNK, INF);
+            }
+        }
+
+        for (int i = 0; i < N; i++) {
+            int cap_src = (i == g.horse_idx) ? INF : 0;
+            src_edge_idx[static_cast<size_t>(i)] = add_edge(SRC, 2 * i + 1, cap_src);
+        }
+
+        flow.finalize();
+    }
+
+    int add_edge(int u, int v, int c) {
+        base_cap.push_back(static_cast<Cap>(c));
+        base_cap.push_back(0);
+        return flow.add_edge(u, v);
+    }
+
+    // Capacities for a search state: deleted cells are cut, forced cells are
+    // uncuttable and fed from SRC. Returns false if a cell is both. Set is
+    // DynamicBitset or CellSet.
+    template <class Set>
+    bool init_caps(const Set& deleted, const Set& forced, vector<Cap>& cap) const {
+        cap = base_cap;
 
         deleted.for_each_set_bit([&](int i) {
             cap[static_cast<size_t>(cell_edge_idx[static_cast<size_t>(i)])] = 0;
@@ -398,27 +1483,552 @@ inline SolveResult solve(int k, const vector<string>& grid) {
         bool ok = true;
         forced.for_each_set_bit([&](int i) {
             if (deleted.test(i)) { ok = false; return; }
-            cap[static_cast<size_t>(cell_edge_idx[static_cast<size_t>(i)])] = INF;
-            cap[static_cast<size_t>(src_edge_idx[static_cast<size_t>(i)])]  = INF;
+            cap[static_cast<size_t>(cell_edge_idx[static_cast<size_t>(i)])] = static_cast<Cap>(INF);
+            cap[static_cast<size_t>(src_edge_idx[static_cast<size_t>(i)])]  = static_cast<Cap>(INF);
         });
-        if (!ok) return false;
+        return ok;
+    }
 
-        int f = flow.maxflow_limit(SRC, SNK, cap, k_rem + 1);
-        if (f > k_rem) return false;
+    // init_caps' change for one more forced / deleted cell, applied to the
+    // saved BkFlow state of a parent search node
+    void force_cell(BkFlow<Cap>& bk, int i) const {
+        int ce = cell_edge_idx[static_cast<size_t>(i)];
+        int se = src_edge_idx[static_cast<size_t>(i)];
+        bk.raise(ce, INF - base_cap[static_cast<size_t>(ce)]);
+        bk.raise(se, INF - base_cap[static_cast<size_t>(se)]);
+    }
 
-        vector<unsigned char> can(static_cast<size_t>(node_count), 0);
-        deque<int> dq;
-        dq.push_back(SNK);
-        can[static_cast<size_t>(SNK)] = 1;
+    void delete_cell(BkFlow<Cap>& bk, int i) const {
+        bk.cut(cell_edge_idx[static_cast<size_t>(i)]);
+    }
+};
 
-        while (!dq.empty()) {
-            int v = dq.front();
-            dq.pop_front();
-            for (int e : flow.in_adj[static_cast<size_t>(v)]) {
-                int u = flow.frm[static_cast<size_t>(e)];
-                if (cap[static_cast<size_t>(e)] > 0 && !can[static_cast<size_t>(u)]) {
-                    can[static_cast<size_t>(u)] = 1;
-                    dq.push_back(u);
+// Which cell of a node's min cuts the DFS branches on. The min cuts of a
+// flow form a lattice (Picard-Queyranne) between the source-closest and the
+// sink-closest cut; a cell in both is in every min cut, so forcing it must
+// raise the flow, and with no budget to spare that child can be skipped.
+enum class Branching {
+    SinkCut,    // first cell of the sink-closest cut
+    MinCuts,    // prefer a cell in every min cut, else as SinkCut
+};
+
+inline bool parse_branching(const string& s, Branching& out) {
+    if (s == "sink-cut") out = Branching::SinkCut;
+    else if (s == "min-cuts") out = Branching::MinCuts;
+    else return false;
+    return true;
+}
+
+// Max-flow engine behind min_separator. All find the same cuts.
+enum class FlowEngine {
+    Auto,               // by board size, see resolve_flow_engine
+    EdmondsKarp,        // FlowTemplate::maxflow_limit from scratch at every node
+    BoykovKolmogorov,   // BkFlow, resuming the parent node's search trees
+    PushRelabel,        // PushRelabel from scratch at every node
+};
+
+inline bool parse_flow_engine(const string& s, FlowEngine& out) {
+    if (s == "auto") out = FlowEngine::Auto;
+    else if (s == "ek") out = FlowEngine::EdmondsKarp;
+    else if (s == "bk") out = FlowEngine::BoykovKolmogorov;
+    else if (s == "pr") out = FlowEngine::PushRelabel;
+    else return false;
+    return true;
+}
+
+// BK was the fastest engine on every board measured, but each search frame
+// on the DFS path may keep a residual network for its children, and forced
+// branches spend no budget, so the path can be far deeper than k. The
+// solver keeps the live snapshots within SolveOptions::bk_snapshot_budget
+// (frames past it leave none and their children start cold). Auto picks
+// push-relabel, which keeps nothing between nodes, once that budget cannot
+// hold even one snapshot per wall that can be placed (k, or fewer if the
+// board has fewer wallable cells), since most nodes would then start cold
+// anyway.
+constexpr size_t BK_SNAPSHOT_BUDGET = size_t(1) << 30;
+
+inline FlowEngine resolve_flow_engine(FlowEngine e, size_t snapshot_bytes, int k, int wallable_cells, size_t budget) {
+    if (e != FlowEngine::Auto) return e;
+    size_t frames = static_cast<size_t>(std::min(k, wallable_cells)) + 1;
+    return snapshot_bytes > budget / frames ? FlowEngine::PushRelabel : FlowEngine::BoykovKolmogorov;
+}
+
+/* ---------------- Kernel Capture ---------------- */
+
+// Inputs of the hot kernels seen during a solve, kept for offline replay by
+// microbench.cpp. Records the first `limit` calls of each kind.
+struct KernelCapture {
+    struct FlowCall {
+        DynamicBitset deleted;
+        DynamicBitset forced;
+        int k_rem = 0;
+    };
+
+    // One ReachTracker call, in search order from a tracker reset with no walls
+    struct ReachOp {
+        enum Kind { Block, Undo, Area };
+        Kind kind = Block;
+        int cell = -1;          // Block
+        DynamicBitset walls;    // Area: area_without(walls)
+    };
+
+    size_t limit = 4096;
+    CellOrder order = CellOrder::Bfs;   // numbering of the recorded sets
+    vector<FlowCall> flow_calls;
+    vector<DynamicBitset> bfs_blocked;
+    vector<ReachOp> reach_ops;
+
+    void record_flow(const DynamicBitset& deleted, const DynamicBitset& forced, int k_rem) {
+        if (flow_calls.size() < limit) flow_calls.push_back({deleted, forced, k_rem});
+    }
+    void record_bfs(const DynamicBitset& blocked) {
+        if (bfs_blocked.size() < limit) bfs_blocked.push_back(blocked);
+    }
+    void record_reach(ReachOp::Kind kind, int cell, const DynamicBitset* walls = nullptr) {
+        if (reach_ops.size() >= limit) return;
+        reach_ops.push_back({kind, cell, walls ? *walls : DynamicBitset()});
+    }
+};
+
+/* ---------------- Separator Cache ---------------- */
+
+// min_separator results for one board, kept across solves (a k sweep, or the
+// web UI re-solving after the budget changes). A flow below its limit is the
+// exact max flow and its sink-closest min cut does not depend on the limit
+// or on k, so it answers every later budget; a flow that hit the limit only
+// proves "more than limit - 1" and answers budgets below that. Keys are raw
+// (deleted, forced) states in the board's cell numbering, so the cache drops
+// its entries when a solve brings a different board or CellOrder. Not
+// thread-safe: one solve at a time.
+struct SeparatorCache {
+    struct Entry {
+        int flow = 0;
+        bool exact = false;      // flow < limit: the max flow, and `sep` is its cut
+        CellSet sep;
+        CellSet essential;       // cells in every min cut, if has_essential
+        bool has_essential = false;   // computed: MinCuts and flow == k_rem of the storing solve
+    };
+
+    size_t max_entries = size_t(1) << 20;   // later results are not stored once full
+    uint64_t board = 0;                     // fingerprint of the board the entries belong to
+    unordered_map<State, Entry, StateHash> entries;
+
+    // Switch to `board_fp`, dropping entries of any other board or branching rule
+    void bind(uint64_t board_fp) {
+        if (board_fp == board && !entries.empty()) return;
+        entries.clear();
+        board = board_fp;
+    }
+
+    static uint64_t fingerprint(const PackedGridView& grid, CellOrder order, Branching branching) {
+        uint64_t h = splitmix64((static_cast<uint64_t>(grid.R) << 32) ^ static_cast<uint64_t>(grid.C));
+        h = splitmix64(h ^ static_cast<uint64_t>(order) ^ (static_cast<uint64_t>(branching) << 8));
+        size_t words = PackedGridView::word_count(grid.R, grid.C);
+        for (size_t i = 0; i < words; i++) h = splitmix64(h ^ grid.bits[i]);
+        return h;
+    }
+};
+
+/* ---------------- Nogoods ---------------- */
+
+// Infeasible states learned during one solve. A min cut above the budget at
+// (D, F) rules out every (D', F') with D a subset of D' and F of F': more
+// forced cells never lower the cut, and each extra wall lowers it by at most
+// the one unit of budget it costs. Each nogood is filed under one of its
+// cells, so a lookup scans only the buckets of the state's own cells.
+struct NogoodStore {
+    struct Nogood {
+        uint64_t sig;            // signature(deleted, forced), a cheap pre-filter for the subset test
+        CellSet deleted;
+        CellSet forced;
+    };
+
+    vector<Nogood> nogoods;
+    unordered_map<int, vector<int>> index;   // 2*cell (deleted) or 2*cell+1 (forced) -> nogoods
+    bool everything = false;                 // an empty nogood was learned
+
+    void add(CellSet deleted, CellSet forced) {
+        if (deleted.empty() && forced.empty()) {
+            everything = true;
+            return;
+        }
+        // File under the member with the shortest bucket
+        int key = -1;
+        size_t shortest = 0;
+        auto consider = [&](int c) {
+            auto it = index.find(c);
+            size_t n = it == index.end() ? 0 : it->second.size();
+            if (key < 0 || n < shortest) { key = c; shortest = n; }
+        };
+        for (int d : deleted.ids) consider(2 * d);
+        for (int f : forced.ids) consider(2 * f + 1);
+        index[key].push_back(static_cast<int>(nogoods.size()));
+        uint64_t sig = signature(deleted, forced);
+        nogoods.push_back({sig, std::move(deleted), std::move(forced)});
+    }
+
+    // One bit per member, so a subset's signature is a subset of the superset's
+    static uint64_t signature(const CellSet& deleted, const CellSet& forced) {
+        uint64_t sig = 0;
+        for (int d : deleted.ids) sig |= 1ULL << (splitmix64(static_cast<uint64_t>(2 * d)) & 63);
+        for (int f : forced.ids) sig |= 1ULL << (splitmix64(static_cast<uint64_t>(2 * f + 1)) & 63);
+        return sig;
+    }
+
+    // True if some nogood is contained in (deleted, forced)
+    bool covers(const CellSet& deleted, const CellSet& forced) const {
+        if (everything) return true;
+        if (nogoods.empty()) return false;
+        const uint64_t sig = signature(deleted, forced);
+        auto scan = [&](int c) {
+            auto it = index.find(c);
+            if (it == index.end()) return false;
+            for (int n : it->second) {
+                const Nogood& ng = nogoods[static_cast<size_t>(n)];
+                if (ng.sig & ~sig) continue;
+                if (std::includes(deleted.ids.begin(), deleted.ids.end(), ng.deleted.ids.begin(), ng.deleted.ids.end()) &&
+                    std::includes(forced.ids.begin(), forced.ids.end(), ng.forced.ids.begin(), ng.forced.ids.end())) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        for (int d : deleted.ids) {
+            if (scan(2 * d)) return true;
+        }
+        for (int f : forced.ids) {
+            if (scan(2 * f + 1)) return true;
+        }
+        return false;
+    }
+};
+
+/* ---------------- Search Statistics ---------------- */
+
+struct SolveStats {
+    uint64_t nodes = 0;              // dfs calls
+    uint64_t memo_hits = 0;          // revisits with no more budget than before
+    uint64_t memo_misses = 0;
+    uint64_t memo_upgrades = 0;      // revisits with a larger k_rem, explored again
+    uint64_t memo_size = 0;          // states in visited_states at the end
+    uint64_t memo_bytes = 0;         // estimated heap footprint of visited_states
+    uint64_t separator_calls = 0;    // min_separator invocations
+    uint64_t separator_cache_hits = 0;   // answered by SolveOptions::separator_cache without a flow
+    uint64_t augmenting_paths = 0;   // flow units augmented
+    uint64_t flow_resumes = 0;       // BK flows resumed from the parent node's trees
+    uint64_t prune_bound = 0;        // reachable area cannot beat the incumbent
+    uint64_t prune_forced = 0;       // a forced cell is no longer reachable
+    uint64_t prune_flow = 0;         // min cut exceeds the remaining budget
+    uint64_t prune_nogood = 0;       // state contains a learned nogood
+    uint64_t prune_essential = 0;    // forced child skipped: its cell is in every min cut and flow == k_rem
+    uint64_t nogoods = 0;            // nogoods learned from failed flows
+    uint64_t prune_leaf = 0;         // no budget left or empty separator
+    uint64_t peak_depth = 0;
+    double graph_ms = 0.0;           // grid -> cell graph
+    double flow_build_ms = 0.0;      // FlowTemplate construction
+    double search_ms = 0.0;          // dfs
+
+    // Visit (name, value) pairs in a stable order, for printers (counters are
+    // uint64_t, timings double)
+    template <class F>
+    void for_each(F&& f) const {
+        f("nodes", nodes);
+        f("memo_hits", memo_hits);
+        f("memo_misses", memo_misses);
+        f("memo_upgrades", memo_upgrades);
+        f("memo_size", memo_size);
+        f("memo_bytes", memo_bytes);
+        f("separator_calls", separator_calls);
+        f("separator_cache_hits", separator_cache_hits);
+        f("augmenting_paths", augmenting_paths);
+        f("flow_resumes", flow_resumes);
+        f("prune_bound", prune_bound);
+        f("prune_forced", prune_forced);
+        f("prune_flow", prune_flow);
+        f("prune_nogood", prune_nogood);
+        f("prune_essential", prune_essential);
+        f("nogoods", nogoods);
+        f("prune_leaf", prune_leaf);
+        f("peak_depth", peak_depth);
+        f("graph_ms", graph_ms);
+        f("flow_build_ms", flow_build_ms);
+        f("search_ms", search_ms);
+    }
+};
+
+/* ---------------- Solver Result ---------------- */
+
+struct SolveResult {
+    int best_area = 0;
+    vector<pair<int,int>> walls;
+    bool timed_out = false;   // search stopped at the deadline; result is the best found so far
+    bool has_stats = false;   // stats is filled only when SolveOptions::collect_stats is set
+    SolveStats stats;
+};
+
+/* ---------------- Solver Options ---------------- */
+
+struct SolveOptions {
+    using clock = std::chrono::steady_clock;
+
+    // Abandon the search at this point in time (default: never). Checked
+    // before each search node, so a solve overruns it by at most one node.
+    clock::time_point deadline = clock::time_point::max();
+
+    // Fill SolveResult::stats. Selects a separate instantiation of the search,
+    // so the default build pays nothing for the counters.
+    bool collect_stats = false;
+
+    // Record timeline events (phases, top-level subtrees, sampled flow/BFS/memo)
+    TraceRecorder* trace = nullptr;
+
+    // Record max-flow and BFS inputs for microbench replay
+    KernelCapture* capture = nullptr;
+
+    // Reuse min separators from earlier solves of the same board
+    SeparatorCache* separator_cache = nullptr;
+
+    // Branching rule; see Branching
+    Branching branching = Branching::MinCuts;
+
+    // Max-flow engine; see FlowEngine. BK keeps one residual network per
+    // search frame on the DFS path, so memory grows with depth x board size.
+    FlowEngine flow_engine = FlowEngine::Auto;
+
+    // Bytes of BK residual snapshots alive at once; see resolve_flow_engine
+    size_t bk_snapshot_budget = BK_SNAPSHOT_BUDGET;
+
+    // Cell numbering used by the graph, flow network and bitsets
+    CellOrder cell_order = CellOrder::Bfs;
+
+    // Key the memo on a normalized state (irrelevant walls and implied forced
+    // cells removed) so equivalent subproblems are explored once. Off keys it
+    // on the raw state, which is checked before the reachability BFS.
+    bool normalize_memo = true;
+
+    // Remember the (walls, forced cells) behind each failed flow and prune
+    // states that contain one. Off by default: a nogood only fires on states
+    // whose own flow would fail, and on the corpus the saved flows about
+    // match the cost of the lookups.
+    bool learn_nogoods = false;
+};
+
+/* ---------------- Solver Implementation ---------------- */
+
+namespace detail {
+
+inline double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+template <bool kStats, class Cap>
+SolveResult solve_impl(int k, const PackedGridView& grid, const SolveOptions& opt) {
+    using clock = std::chrono::steady_clock;
+    SolveStats st;
+    clock::time_point phase_t0;
+    if (kStats) phase_t0 = clock::now();
+
+    TraceRecorder* trace = opt.trace;
+    TraceScope solve_span(trace, "solve", "solve", trace ? "\"k\":" + std::to_string(k) : string());
+    clock::time_point trace_t0;
+    if (trace) trace_t0 = clock::now();
+
+    CellGraph g = build_cell_graph(grid, opt.cell_order);
+    const int N = g.N;
+    const int horse_idx = g.horse_idx;
+    const vector<pair<int,int>>& coords = g.coords;
+    const vector<unsigned char>& wallable = g.wallable;
+
+    if (g.boundary.test(horse_idx)) {
+        SolveResult res;
+        res.has_stats = kStats;
+        return res;
+    }
+
+    if (kStats) {
+        st.graph_ms = ms_since(phase_t0);
+        phase_t0 = clock::now();
+    }
+    if (trace) {
+        clock::time_point now = clock::now();
+        trace->complete("graph", "setup", trace_t0, now, "\"cells\":" + std::to_string(N));
+        trace_t0 = now;
+    }
+
+    const SeparatorNetwork<Cap> net(g, k);
+    const FlowTemplate& flow = net.flow;
+    const int node_count = net.node_count;
+    const int SRC = net.SRC;
+    const int SNK = net.SNK;
+
+    if (kStats) {
+        st.flow_build_ms = ms_since(phase_t0);
+        phase_t0 = clock::now();
+    }
+    if (trace) {
+        trace->complete("flow_template", "setup", trace_t0, clock::now(),
+                        "\"edges\":" + std::to_string(flow.to.size()));
+    }
+
+    KernelCapture* capture = opt.capture;
+    if (capture) capture->order = opt.cell_order;
+    unsigned bfs_calls = 0, flow_calls = 0, memo_calls = 0;
+
+    // Dense mirrors of the current DFS state's deleted / forced sets, kept in
+    // step with the recursion for O(1) membership in the BFS and cut scans
+    DynamicBitset deleted_mask(N), forced_mask(N);
+
+    // Region reachable under deleted_mask, updated as walls are pushed and
+    // popped instead of a BFS per node
+    ReachTracker reach(g);
+    reach.reset(deleted_mask);
+
+    // Area enclosed if sep were walled on top of deleted_mask (-1 if it
+    // escapes), searched inside the tracked region
+    auto candidate_area = [&](const DynamicBitset& sep) {
+        if (capture) {
+            capture->record_bfs(deleted_mask | sep);
+            capture->record_reach(KernelCapture::ReachOp::Area, -1, &sep);
+        }
+        TraceScope span(trace && trace->sample(bfs_calls) ? trace : nullptr, "bfs", "search");
+        return reach.area_without(sep);
+    };
+
+    SeparatorCache* sep_cache = opt.separator_cache;
+    if (sep_cache) sep_cache->bind(SeparatorCache::fingerprint(grid, opt.cell_order, opt.branching));
+    const bool want_essential = opt.branching == Branching::MinCuts;
+
+    auto remember_separator = [&](const CellSet& deleted, const CellSet& forced, SeparatorCache::Entry e) {
+        State key{deleted, forced};
+        auto it = sep_cache->entries.find(key);
+        if (it != sep_cache->entries.end()) it->second = std::move(e);
+        else if (sep_cache->entries.size() < sep_cache->max_entries) sep_cache->entries.emplace(std::move(key), std::move(e));
+    };
+
+    // BK flows resume from the parent node's trees: the search loop points
+    // bk_parent at the parent frame's saved state and names the cell that
+    // changed; bk_fresh says bk.state belongs to the node just expanded
+    const size_t bk_snapshot = flow.to.size() * sizeof(Cap) + static_cast<size_t>(flow.n) * (sizeof(unsigned char) + sizeof(int));
+    const int wallable_cells = static_cast<int>(std::count(wallable.begin(), wallable.end(), 1));
+    const FlowEngine engine = resolve_flow_engine(opt.flow_engine, bk_snapshot, k, wallable_cells, opt.bk_snapshot_budget);
+    const bool use_bk = engine == FlowEngine::BoykovKolmogorov;
+    const bool use_pr = engine == FlowEngine::PushRelabel;
+    BkFlow<Cap> bk(flow, SRC, SNK);
+    PushRelabel<Cap> pr(flow);
+    typename BkFlow<Cap>::State* bk_parent = nullptr;
+    int bk_cell = -1;
+    bool bk_cell_forced = false;
+    bool bk_fresh = false;
+    size_t bk_live = 0;   // bytes held in Frame::bk, at most opt.bk_snapshot_budget
+
+    NogoodStore nogoods;
+
+    // Keep only the forced cells the failing flow depends on: a cell whose
+    // source edge is unused and whose cell edge carries no more than its
+    // unforced capacity can be released without invalidating the flow
+    auto learn_nogood = [&](const CellSet& deleted, const CellSet& forced, const vector<Cap>& cap) {
+        CellSet needed;
+        for (int x : forced.ids) {
+            if (x == horse_idx) continue;
+            int src_flow = net.INF - cap[static_cast<size_t>(net.src_edge_idx[static_cast<size_t>(x)])];
+            int cell_flow = net.INF - cap[static_cast<size_t>(net.cell_edge_idx[static_cast<size_t>(x)])];
+            int unforced = wallable[static_cast<size_t>(x)] ? 1 : net.INF;
+            if (src_flow > 0 || cell_flow > unforced) needed.ids.push_back(x);
+        }
+        nogoods.add(deleted, std::move(needed));
+        if (kStats) st.nogoods++;
+    };
+
+    // Sink-closest min cut of the state (and, for Branching::MinCuts, the
+    // cells in every min cut) with its flow; false if the cut exceeds k_rem
+    auto min_separator = [&](const CellSet& deleted,
+                             const CellSet& forced,
+                             int k_rem,
+                             DynamicBitset& sep_out,
+                             DynamicBitset& essential_out,
+                             int& flow_out) -> bool {
+        if (sep_cache) {
+            auto it = sep_cache->entries.find(State{deleted, forced});
+            // An entry stored at a larger k_rem has no essential cells; a
+            // node that needs them recomputes and refreshes the entry
+            if (it != sep_cache->entries.end() && (it->second.exact || it->second.flow > k_rem) &&
+                !(want_essential && it->second.flow == k_rem && !it->second.has_essential)) {
+                if (kStats) st.separator_cache_hits++;
+                if (it->second.flow > k_rem) return false;
+                flow_out = it->second.flow;
+                sep_out.init(N);
+                for (int i : it->second.sep.ids) sep_out.set(i);
+                if (want_essential && flow_out == k_rem) {
+                    essential_out.init(N);
+                    for (int i : it->second.essential.ids) essential_out.set(i);
+                }
+                return true;
+            }
+        }
+
+        vector<Cap> local_cap;
+        if (!bk_parent && !net.init_caps(deleted, forced, local_cap)) return false;
+        if (capture) capture->record_flow(deleted_mask, forced_mask, k_rem);
+
+        int f, f0 = 0;
+        {
+            TraceScope span(trace && trace->sample(flow_calls) ? trace : nullptr, "maxflow", "search");
+            if (use_pr) {
+                f = pr.maxflow_limit(SRC, SNK, local_cap, k_rem + 1);
+            } else if (!use_bk) {
+                f = flow.maxflow_limit(SRC, SNK, local_cap, k_rem + 1);
+            } else {
+                if (bk_parent) {
+                    // The forced sibling still needs the parent state; the
+                    // deleted child is the last to use it
+                    if (bk_cell_forced) bk.state = *bk_parent;
+                    else bk.state = std::move(*bk_parent);
+                    bk.resume();
+                    if (bk_cell_forced) net.force_cell(bk, bk_cell);
+                    else net.delete_cell(bk, bk_cell);
+                    f0 = bk.state.flow;
+                    if (kStats) st.flow_resumes++;
+                } else {
+                    bk.start(local_cap);
+                }
+                f = bk.run(k_rem + 1);
+            }
+        }
+        const vector<Cap>& cap = use_bk ? bk.state.cap : local_cap;
+        if (kStats) {
+            st.separator_calls++;
+            st.augmenting_paths += static_cast<uint64_t>(f - f0);
+        }
+        if (f > k_rem) {
+            if (sep_cache) remember_separator(deleted, forced, {f, false, CellSet(), CellSet()});
+            if (opt.learn_nogoods) learn_nogood(deleted, forced, cap);
+            return false;
+        }
+
+        // Residual sink side: BK's sink tree, push-relabel's final heights,
+        // else a BFS back from SNK
+        vector<unsigned char> can;
+        deque<int> dq;
+        if (use_bk) {
+            can.resize(static_cast<size_t>(node_count));
+            for (size_t x = 0; x < can.size(); x++) can[x] = bk.state.tree[x] == BkFlow<Cap>::SINK;
+        } else if (use_pr) {
+            can.resize(static_cast<size_t>(node_count));
+            for (int x = 0; x < node_count; x++) can[static_cast<size_t>(x)] = pr.sink_side(x);
+        } else {
+            can.assign(static_cast<size_t>(node_count), 0);
+            dq.push_back(SNK);
+            can[static_cast<size_t>(SNK)] = 1;
+            while (!dq.empty()) {
+                int v = dq.front();
+                dq.pop_front();
+                // e leaves v, so e ^ 1 is the residual edge u -> v
+                for (int e : flow.edges(v)) {
+                    int u = flow.to[static_cast<size_t>(e)];
+                    if (cap[static_cast<size_t>(e ^ 1)] > 0 && !can[static_cast<size_t>(u)]) {
+                        can[static_cast<size_t>(u)] = 1;
+                        dq.push_back(u);
+                    }
                 }
             }
         }
@@ -426,68 +2036,274 @@ inline SolveResult solve(int k, const vector<string>& grid) {
         sep_out.init(N);
         for (int i = 0; i < N; i++) {
             if (!wallable[static_cast<size_t>(i)]) continue;
-            if (deleted.test(i) || forced.test(i)) continue;
+            if (deleted_mask.test(i) || forced_mask.test(i)) continue;
             int inn = 2 * i;
             int out = 2 * i + 1;
             if (!can[static_cast<size_t>(inn)] && can[static_cast<size_t>(out)]) sep_out.set(i);
         }
+        flow_out = f;
+        bk_fresh = use_bk;
+
+        if (want_essential && f == k_rem && use_bk) {
+            essential_out.init(N);
+            sep_out.for_each_set_bit([&](int i) {
+                if (bk.state.tree[static_cast<size_t>(2 * i)] == BkFlow<Cap>::SOURCE) essential_out.set(i);
+            });
+        } else if (want_essential && f == k_rem) {
+            // Source-closest cut: nodes reachable from SRC in the residual
+            // graph. A cut cell whose in-node is on this side is in every min
+            // cut. Only worth a second BFS when no budget is left to spare.
+            vector<unsigned char> src_side(static_cast<size_t>(node_count), 0);
+            dq.push_back(SRC);
+            src_side[static_cast<size_t>(SRC)] = 1;
+            while (!dq.empty()) {
+                int u = dq.front();
+                dq.pop_front();
+                for (int e : flow.edges(u)) {
+                    int v = flow.to[static_cast<size_t>(e)];
+                    if (cap[static_cast<size_t>(e)] > 0 && !src_side[static_cast<size_t>(v)]) {
+                        src_side[static_cast<size_t>(v)] = 1;
+                        dq.push_back(v);
+                    }
+                }
+            }
+            essential_out.init(N);
+            sep_out.for_each_set_bit([&](int i) {
+                if (src_side[static_cast<size_t>(2 * i)]) essential_out.set(i);
+            });
+        }
+
+        if (sep_cache) {
+            SeparatorCache::Entry e{f, true, CellSet(), CellSet()};
+            sep_out.for_each_set_bit([&](int i) { e.sep.ids.push_back(i); });
+            if (want_essential && f == k_rem) {
+                essential_out.for_each_set_bit([&](int i) { e.essential.ids.push_back(i); });
+                e.has_essential = true;
+            }
+            remember_separator(deleted, forced, std::move(e));
+        }
         return true;
     };
 
     int best_area = 0;
     DynamicBitset best_walls(N);
 
-    DynamicBitset start_forced(N);
-    start_forced.set(horse_idx);
+    CellSet start_forced;
+    start_forced.ids.push_back(horse_idx);
+    forced_mask.set(horse_idx);
 
-    unordered_set<State, StateHash> visited_states;
+    unordered_map<State, int, StateHash> visited_states;   // -> largest k_rem explored
     visited_states.reserve(1u << 16);
 
-    function<void(const DynamicBitset&, const DynamicBitset&, int)> dfs =
-        [&](const DynamicBitset& deleted, const DynamicBitset& forced, int k_rem) {
-            State st{deleted, forced, k_rem};
-            if (visited_states.find(st) != visited_states.end()) return;
-            visited_states.insert(st);
+    const bool has_deadline = opt.deadline != SolveOptions::clock::time_point::max();
+    bool timed_out = false;
 
-            DynamicBitset vis_now;
-            int ub_area = 0;
-            bool esc_dummy = false;
-            bfs_reachable(deleted, vis_now, ub_area, esc_dummy);
-            if (ub_area <= best_area) return;
+    uint64_t memo_payload = 0;   // heap bytes of the stored CellSets
 
-            if (!forced.subset_of(vis_now)) return;
+    // Returns false if the state was already explored with at least k_rem
+    auto memo_insert = [&](State&& key, int k_rem) -> bool {
+        TraceScope span(trace && trace->sample(memo_calls) ? trace : nullptr, "memo_lookup", "search");
+        size_t payload = key.deleted.ids.size() + key.forced.ids.size();
+        auto ins = visited_states.emplace(std::move(key), k_rem);
+        if (!ins.second) {
+            if (ins.first->second >= k_rem) {
+                if (kStats) st.memo_hits++;
+                return false;
+            }
+            ins.first->second = k_rem;
+            if (kStats) st.memo_upgrades++;
+            return true;
+        }
+        if (kStats) {
+            st.memo_misses++;
+            memo_payload += static_cast<uint64_t>(payload) * sizeof(int);
+        }
+        return true;
+    };
 
-            DynamicBitset sep;
-            if (!min_separator(deleted, forced, k_rem, sep)) return;
+    // Reduce a state (whose forced cells are all reachable) to the parts that
+    // can still influence the search, so equivalent subproblems share a key:
+    // - a wall with no neighbour in the reachable region is dropped; it can
+    //   never border the region again as walls only shrink it. The budget
+    //   spent on it stays spent.
+    // - a forced cell off the boundary whose open neighbours are all forced
+    //   or walls is dropped, as is the horse: no min cut can contain it and it
+    //   stays reachable through its forced neighbours.
+    auto normalized_key = [&](const CellSet& deleted, const CellSet& forced,
+                              const DynamicBitset& reach) -> State {
+        State key;
+        for (int d : deleted.ids) {
+            for (int u : g.neighbors(d)) {
+                if (reach.test(u)) { key.deleted.ids.push_back(d); break; }
+            }
+        }
+        for (int f : forced.ids) {
+            if (f == horse_idx) continue;
+            bool interior = !g.boundary.test(f);
+            for (int u : g.neighbors(f)) {
+                if (!interior) break;
+                if (!forced_mask.test(u) && !deleted_mask.test(u)) interior = false;
+            }
+            if (!interior) key.forced.ids.push_back(f);
+        }
+        return key;
+    };
 
-            DynamicBitset cand_walls = deleted | sep;
+    // Work at one search node: prune it, or update the incumbent and return
+    // the cell to branch on (-1 for a leaf). skip_forced is set when the
+    // child with that cell forced is known to be infeasible.
+    auto expand = [&](const CellSet& deleted, const CellSet& forced, int k_rem, int depth,
+                      bool& skip_forced) -> int {
+        skip_forced = false;
+        bk_fresh = false;
+        if (kStats) {
+            st.nodes++;
+            if (static_cast<uint64_t>(depth) > st.peak_depth) st.peak_depth = static_cast<uint64_t>(depth);
+        }
+        // every node: one can take tens of ms on a large board, and a
+        // clock read is far cheaper than any node
+        if (has_deadline && SolveOptions::clock::now() >= opt.deadline) {
+            timed_out = true;
+            return -1;
+        }
 
-            DynamicBitset vis2;
-            int area2 = 0;
-            bool escapes2 = false;
-            bfs_reachable(cand_walls, vis2, area2, escapes2);
+        if (opt.learn_nogoods && nogoods.covers(deleted, forced)) {
+            if (kStats) st.prune_nogood++;
+            return -1;
+        }
 
-            if (!escapes2 && area2 > best_area) {
-                best_area = area2;
-                best_walls = cand_walls;
-            }
+        if (!opt.normalize_memo && !memo_insert(State{deleted, forced}, k_rem)) return -1;
 
-            if (k_rem == 0 || sep.empty()) return;
+        const DynamicBitset& vis_now = reach.region();
+        if (reach.area() <= best_area) {
+            if (kStats) st.prune_bound++;
+            return -1;
+        }
 
-            int v = sep.first_set_bit();
-            if (v < 0) return;
+        bool forced_reachable = true;
+        for (int f : forced.ids) {
+            if (!vis_now.test(f)) { forced_reachable = false; break; }
+        }
+        if (!forced_reachable) {
+            if (kStats) st.prune_forced++;
+            return -1;
+        }
 
-            DynamicBitset forced2 = forced;
-            forced2.set(v);
-            dfs(deleted, forced2, k_rem);
+        if (opt.normalize_memo && !memo_insert(normalized_key(deleted, forced, vis_now), k_rem)) return -1;
 
-            DynamicBitset deleted2 = deleted;
-            deleted2.set(v);
-            dfs(deleted2, forced, k_rem - 1);
-        };
+        DynamicBitset sep, essential;
+        int sep_flow = 0;
+        if (!min_separator(deleted, forced, k_rem, sep, essential, sep_flow)) {
+            if (kStats) st.prune_flow++;
+            return -1;
+        }
 
-    DynamicBitset empty_deleted(N);
-    dfs(empty_deleted, start_forced, k);
+        int area2 = candidate_area(sep);
+        if (area2 > best_area) {
+            best_area = area2;
+            best_walls = deleted_mask | sep;
+        }
+
+        if (k_rem == 0 || sep.empty()) {
+            if (kStats) st.prune_leaf++;
+            return -1;
+        }
+        if (want_essential) {
+            int v = essential.first_set_bit();
+            if (v >= 0) {
+                skip_forced = sep_flow == k_rem;
+                if (kStats && skip_forced) st.prune_essential++;
+                return v;
+            }
+        }
+        return sep.first_set_bit();
+    };
+
+    // Depth-first over an explicit stack (a chain of forced branches can be
+    // as deep as the board is large). A frame branches on v twice: first
+    // with v forced, then with v deleted; the dense masks and the reach
+    // tracker follow the frame on top of the stack.
+    struct Frame {
+        CellSet deleted;
+        CellSet forced;
+        int k_rem = 0;
+        int depth = 0;
+        int v = -1;
+        int stage = 0;                  // 0: not expanded, 1: forced child done next, 2: deleted child
+        clock::time_point span_t0;      // depth-1 subtree span when tracing
+        typename BkFlow<Cap>::State bk; // this node's BK flow, for its children
+
+        Frame(CellSet d, CellSet f, int k_rem_, int depth_)
+            : deleted(std::move(d)), forced(std::move(f)), k_rem(k_rem_), depth(depth_) {}
+    };
+    vector<Frame> stack;
+
+    {
+        TraceScope span(trace, "search", "solve");
+        stack.push_back(Frame(CellSet(), start_forced, k, 0));
+        while (!stack.empty() && !timed_out) {
+            Frame& fr = stack.back();
+            if (fr.stage == 0) {
+                fr.stage = 1;
+                if (trace && fr.depth == 1) fr.span_t0 = clock::now();
+                bool skip_forced = false;
+                bk_parent = nullptr;
+                if (use_bk && stack.size() > 1) {
+                    Frame& parent = stack[stack.size() - 2];
+                    if (!parent.bk.cap.empty()) {
+                        bk_parent = &parent.bk;
+                        bk_cell = parent.v;
+                        bk_cell_forced = parent.stage == 1;
+                    }
+                }
+                fr.v = expand(fr.deleted, fr.forced, fr.k_rem, fr.depth, skip_forced);
+                if (bk_parent && !bk_cell_forced) {
+                    // the deleted child was the last user (it may have been
+                    // pruned before its flow and left the state in place)
+                    *bk_parent = typename BkFlow<Cap>::State();
+                    bk_live -= bk_snapshot;
+                }
+                if (fr.v >= 0 && bk_fresh && bk_live + bk_snapshot <= opt.bk_snapshot_budget) {
+                    fr.bk = std::move(bk.state);
+                    bk_live += bk_snapshot;
+                }
+                if (fr.v >= 0 && skip_forced) continue;   // straight to the deleted child
+                if (fr.v >= 0) {
+                    forced_mask.set(fr.v);
+                    Frame child(fr.deleted, fr.forced.with(fr.v), fr.k_rem, fr.depth + 1);
+                    stack.push_back(std::move(child));
+                    continue;
+                }
+            } else if (fr.stage == 1) {
+                fr.stage = 2;
+                forced_mask.reset(fr.v);
+                deleted_mask.set(fr.v);
+                reach.block(fr.v);
+                if (capture) capture->record_reach(KernelCapture::ReachOp::Block, fr.v);
+                Frame child(fr.deleted.with(fr.v), fr.forced, fr.k_rem - 1, fr.depth + 1);
+                stack.push_back(std::move(child));
+                continue;
+            } else {
+                deleted_mask.reset(fr.v);
+                reach.undo();
+                if (capture) capture->record_reach(KernelCapture::ReachOp::Undo, -1);
+            }
+            if (trace && fr.depth == 1) {
+                trace->complete("subtree", "search", fr.span_t0, clock::now(),
+                                "\"k_rem\":" + std::to_string(fr.k_rem));
+            }
+            stack.pop_back();
+        }
+    }
+
+    if (kStats) {
+        st.search_ms = ms_since(phase_t0);
+        st.memo_size = visited_states.size();
+        st.memo_bytes = static_cast<uint64_t>(visited_states.size()) *
+                            (sizeof(std::pair<const State, int>) + 2 * sizeof(void*)) +
+                        memo_payload +
+                        static_cast<uint64_t>(visited_states.bucket_count()) * sizeof(void*);
+    }
 
     vector<pair<int,int>> walls;
     best_walls.for_each_set_bit([&](int i) {
@@ -498,7 +2314,35 @@ inline SolveResult solve(int k, const vector<string>& grid) {
     SolveResult res;
     res.best_area = best_area;
     res.walls = std::move(walls);
+    res.timed_out = timed_out;
+    res.has_stats = kStats;
+    if (kStats) res.stats = st;
     return res;
 }
 
+template <class Cap>
+SolveResult solve_with_cap(int k, const PackedGridView& grid, const SolveOptions& opt) {
+    return opt.collect_stats ? solve_impl<true, Cap>(k, grid, opt)
+                             : solve_impl<false, Cap>(k, grid, opt);
+}
+
+} // namespace detail
+
+// Large boards can be streamed into a PackedGrid, or mapped from a corpus,
+// and solved without a text copy
+inline SolveResult solve(int k, const PackedGridView& grid, const SolveOptions& opt) {
+    if (k < INT8_MAX) return detail::solve_with_cap<int8_t>(k, grid, opt);
+    if (k < INT16_MAX) return detail::solve_with_cap<int16_t>(k, grid, opt);
+    return detail::solve_with_cap<int>(k, grid, opt);
+}
+
+inline SolveResult solve(int k, const vector<string>& grid, const SolveOptions& opt) {
+    PackedGrid pg = PackedGrid::from_rows(grid);
+    return solve(k, pg.view(), opt);
+}
+
+inline SolveResult solve(int k, const vector<string>& grid) {
+    return solve(k, grid, SolveOptions());
+}
+
 } // namespace enclose
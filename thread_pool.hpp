@@ -0,0 +1,92 @@
+#pragma once
+
+// thread_pool.hpp - Fixed-size worker pool shared by the batch and server modes
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace enclose {
+
+class ThreadPool {
+public:
+    // max_pending bounds the number of queued (not yet started) jobs;
+    // submit() blocks while the queue is full. 0 means unbounded.
+    explicit ThreadPool(int threads, std::size_t max_pending = 0) : max_pending_(max_pending) {
+        if (threads < 1) threads = 1;
+        workers_.reserve(static_cast<std::size_t>(threads));
+        for (int i = 0; i < threads; i++) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        cv_job_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    void submit(std::function<void()> job) {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_space_.wait(lk, [&] { return max_pending_ == 0 || jobs_.size() < max_pending_; });
+        jobs_.push_back(std::move(job));
+        lk.unlock();
+        cv_job_.notify_one();
+    }
+
+    // Block until every submitted job has finished.
+    void wait_idle() {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_idle_.wait(lk, [&] { return jobs_.empty() && running_ == 0; });
+    }
+
+    static int default_threads() {
+        unsigned n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : static_cast<int>(n);
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mu_;
+    std::condition_variable cv_job_, cv_space_, cv_idle_;
+    std::size_t max_pending_ = 0;
+    int running_ = 0;
+    bool stopping_ = false;
+
+    void worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_job_.wait(lk, [&] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+                running_++;
+            }
+            cv_space_.notify_one();
+            job();
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                running_--;
+                if (jobs_.empty() && running_ == 0) cv_idle_.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace enclose
@@ -0,0 +1,124 @@
+#pragma once
+
+// trace.hpp - Scoped timeline events exported as Chrome trace JSON
+// (load the file in https://ui.perfetto.dev or chrome://tracing)
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace enclose {
+
+class TraceRecorder {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // High-frequency events (flow, BFS, memo lookups) are recorded for one
+    // call in every sample_every; phase-level events are always recorded.
+    explicit TraceRecorder(unsigned sample_every = 64)
+        : sample_every_(sample_every == 0 ? 1 : sample_every), t0_(clock::now()) {}
+
+    unsigned sample_every() const { return sample_every_; }
+
+    bool sample(unsigned& counter) const {
+        return (counter++ % sample_every_) == 0;
+    }
+
+    // args is a pre-rendered JSON object body (e.g. "\"k\":6"), may be empty
+    void complete(const char* name, const char* cat, clock::time_point begin, clock::time_point end,
+                  std::string args = std::string()) {
+        Event ev;
+        ev.name = name;
+        ev.cat = cat;
+        ev.ts_us = to_us(begin);
+        ev.dur_us = std::chrono::duration<double, std::micro>(end - begin).count();
+        ev.args = std::move(args);
+        std::lock_guard<std::mutex> lk(mu_);
+        ev.tid = thread_index();
+        events_.push_back(std::move(ev));
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return events_.size();
+    }
+
+    void write_json(std::ostream& os) {
+        std::lock_guard<std::mutex> lk(mu_);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"enclose solver\"}}";
+        for (size_t t = 0; t < threads_.size(); t++) {
+            os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+               << ",\"args\":{\"name\":\"thread " << t << "\"}}";
+        }
+        for (const auto& ev : events_) {
+            os << ",\n{\"name\":\"" << ev.name << "\",\"cat\":\"" << ev.cat
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ev.tid
+               << ",\"ts\":" << ev.ts_us << ",\"dur\":" << ev.dur_us;
+            if (!ev.args.empty()) os << ",\"args\":{" << ev.args << "}";
+            os << "}";
+        }
+        os << "\n]}\n";
+    }
+
+private:
+    struct Event {
+        const char* name;
+        const char* cat;
+        double ts_us;
+        double dur_us;
+        uint32_t tid;
+        std::string args;
+    };
+
+    unsigned sample_every_;
+    clock::time_point t0_;
+    std::mutex mu_;
+    std::vector<Event> events_;
+    std::vector<std::thread::id> threads_;
+    std::unordered_map<std::thread::id, uint32_t> tid_of_;
+
+    double to_us(clock::time_point t) const {
+        return std::chrono::duration<double, std::micro>(t - t0_).count();
+    }
+
+    // Small stable thread numbers in order of first appearance (caller holds mu_)
+    uint32_t thread_index() {
+        std::thread::id id = std::this_thread::get_id();
+        auto it = tid_of_.find(id);
+        if (it != tid_of_.end()) return it->second;
+        uint32_t idx = static_cast<uint32_t>(threads_.size());
+        threads_.push_back(id);
+        tid_of_[id] = idx;
+        return idx;
+    }
+};
+
+// RAII span; a null recorder makes it a no-op
+class TraceScope {
+public:
+    TraceScope(TraceRecorder* rec, const char* name, const char* cat, std::string args = std::string())
+        : rec_(rec), name_(name), cat_(cat), args_(std::move(args)) {
+        if (rec_) begin_ = TraceRecorder::clock::now();
+    }
+    ~TraceScope() {
+        if (rec_) rec_->complete(name_, cat_, begin_, TraceRecorder::clock::now(), std::move(args_));
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceRecorder* rec_;
+    const char* name_;
+    const char* cat_;
+    std::string args_;
+    TraceRecorder::clock::time_point begin_;
+};
+
+} // namespace enclose